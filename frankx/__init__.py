@@ -11,6 +11,7 @@ from _frankx import (
     LinearRelativeMotion,
     Measure,
     MotionData,
+    PathInterpolation,
     PathMotion,
     PositionHold,
     Reaction,
@@ -12,12 +12,15 @@
 #include <franka/robot_state.h>
 
 #include <movex/otg/parameter.hpp>
+#include <movex/robot/dynamics.hpp>
+#include <movex/robot/kinematics.hpp>
 #include <movex/robot/motion_data.hpp>
 #include <movex/robot/robot_state.hpp>
 #include <movex/motion/motion_impedance.hpp>
 #include <movex/motion/motion_joint.hpp>
 #include <movex/motion/motion_path.hpp>
 #include <movex/motion/motion_waypoint.hpp>
+#include <movex/path/trajectory_cache.hpp>
 #include <movex/otg/quintic.hpp>
 #include <movex/otg/smoothie.hpp>
 #include <movex/otg/ruckig.hpp>
@@ -30,6 +33,7 @@
 namespace movex {
     class ImpedanceMotion;
     class JointMotion;
+    class JointPathMotion;
     class PathMotion;
     class WaypointMotion;
 }
@@ -38,8 +42,8 @@ namespace frankx {
     using namespace movex;
 
 class Robot: public franka::Robot {
-    std::tuple<std::array<double, 7>, std::array<double, 7>, std::array<double, 7>> getInputLimits(const MotionData& data);
-    std::tuple<std::array<double, 7>, std::array<double, 7>, std::array<double, 7>> getInputLimits(const Waypoint& waypoint, const MotionData& data);
+    std::tuple<std::array<double, 7>, std::array<double, 7>, std::array<double, 7>> getInputLimits(const MotionData& data, bool commands_joint_positions = false);
+    std::tuple<std::array<double, 7>, std::array<double, 7>, std::array<double, 7>> getInputLimits(const Waypoint& waypoint, const MotionData& data, bool commands_joint_positions = false);
     void setInputLimits(InputParameter<7>& input_parameters, const MotionData& data);
     void setInputLimits(InputParameter<7>& input_parameters, const Waypoint& waypoint, const MotionData& data);
 
@@ -97,6 +101,7 @@ public:
     // Joint constraints
     static constexpr std::array<double, 7> max_joint_velocity {{2.175, 2.175, 2.175, 2.175, 2.610, 2.610, 2.610}}; // [rad/s]
     static constexpr std::array<double, 7> max_joint_acceleration {{15.0, 7.5, 10.0, 12.5, 15.0, 20.0, 20.0}}; // [rad/s²]
+    static constexpr std::array<double, 7> max_joint_jerk {{7500.0, 3750.0, 5000.0, 6250.0, 7500.0, 10000.0, 10000.0}}; // [rad/s³]
 
     double velocity_rel {1.0};
     double acceleration_rel {1.0};
@@ -113,6 +118,9 @@ public:
     //! Whether the robot stops if a python error signal is detected.
     bool stop_at_python_signal {true};
 
+    //! Cache of path motion trajectories to skip the planning of repeated motions, disabled if empty.
+    std::shared_ptr<TrajectoryCache> trajectory_cache;
+
     //! Connects to a robot at the given FCI IP address.
     explicit Robot(std::string fci_ip, double dynamic_rel = 1.0, bool repeat_on_error = true, bool stop_at_python_signal = true);
 
@@ -123,8 +131,10 @@ public:
     bool recoverFromErrors();
 
     Affine currentPose(const Affine& frame = Affine());
-    // Affine forwardKinematics(const std::array<double, 7>& q);
-    // std::array<double, 7> inverseKinematics(const Affine& target, const Affine& frame = Affine());
+    //! Forward kinematics with the Franka Hand as end effector, see movex::Kinematics for other ones. Does not need a connection to the robot.
+    static Affine forwardKinematics(const std::array<double, 7>& q);
+    //! Joint positions that reach the target pose of the frame with the current q7, closest to the current joint positions
+    std::optional<std::array<double, 7>> inverseKinematics(const Affine& target, const Affine& frame = Affine());
 
     bool move(ImpedanceMotion& motion);
     bool move(ImpedanceMotion& motion, MotionData& data);
@@ -136,6 +146,9 @@ public:
     bool move(const Affine& frame, JointMotion motion);
     bool move(const Affine& frame, JointMotion motion, MotionData& data);
 
+    bool move(JointPathMotion motion);
+    bool move(JointPathMotion motion, MotionData& data);
+
     bool move(PathMotion motion);
     bool move(PathMotion motion, MotionData& data);
     bool move(const Affine& frame, PathMotion motion);
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+
+namespace movex {
+
+//! Read-only memory mapping of a whole file. All pages are read on construction and locked in memory if possible.
+struct FileMapping {
+    const char* data {nullptr};
+    size_t size {0};
+
+    //! Whether the pages are locked in memory, otherwise they might be paged out again
+    bool is_locked {false};
+
+    explicit FileMapping(const std::string& filename);
+    ~FileMapping();
+
+    FileMapping(const FileMapping&) = delete;
+    FileMapping& operator=(const FileMapping&) = delete;
+};
+
+} // namespace movex
@@ -59,6 +59,13 @@ public:
     bool is_active {false};
     bool should_finish {false};
 
+    //! Calculates the Jacobian with the analytic kinematics of movex instead of the libfranka model in each cycle
+    bool analytic_jacobian {false};
+
+    //! Compensates the Coriolis torques with the identified dynamics of movex (without friction) instead of the
+    //! libfranka model
+    bool identified_dynamics {false};
+
     explicit ImpedanceMotion() { }
     explicit ImpedanceMotion(double joint_stiffness): joint_stiffness(joint_stiffness), type(Type::Joint) { }
     explicit ImpedanceMotion(double translational_stiffness, double rotational_stiffness): translational_stiffness(translational_stiffness), rotational_stiffness(rotational_stiffness), type(Type::Cartesian) { }
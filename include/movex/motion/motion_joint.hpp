@@ -1,5 +1,8 @@
 #pragma once
 
+#include <array>
+#include <vector>
+
 #include <Eigen/Core>
 
 
@@ -12,4 +15,15 @@ struct JointMotion {
     explicit JointMotion(const std::array<double, 7> target): target(target.data()) { }
 };
 
+
+//! A motion along a path through joint waypoints, starting at the current joint positions
+struct JointPathMotion {
+    std::vector<std::array<double, 7>> waypoints;
+
+    //! Maximum distance for blending at the waypoints in the joint space in [rad]
+    double blend_max_distance {0.0};
+
+    explicit JointPathMotion(const std::vector<std::array<double, 7>>& waypoints, double blend_max_distance = 0.0): waypoints(waypoints), blend_max_distance(blend_max_distance) { }
+};
+
 } // namespace movex
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <memory>
+#include <mutex>
+#include <optional>
+
 #include <Eigen/Core>
 
 #include <movex/path/path.hpp>
+#include <movex/path/trajectory_file.hpp>
 #include <movex/waypoint.hpp>
 
 
@@ -11,13 +16,54 @@ namespace movex {
 struct PathMotion {
     std::vector<Waypoint> waypoints;
 
+    //! Interpolation of the path between the waypoints
+    Path::Interpolation interpolation {Path::Interpolation::Linear};
+
+    //! Constant tool speed along the path in [m/s] instead of the fastest motion, e.g. for dispensing or deburring
+    std::optional<double> max_tool_velocity;
+
+    //! Plans the whole trajectory before the motion starts and slows down the sections that would exceed the joint
+    //! velocity, acceleration or jerk limits, instead of aborting with a discontinuity error. The elbow is commanded along
+    //! the checked joint positions, so that the robot's inverse kinematics follows them. Appended waypoints are ignored then.
+    bool check_joint_limits {false};
+
+    //! Converts the whole trajectory to joint positions before the motion starts, and commands these instead of the
+    //! Cartesian poses. The joint limits (including the jerk) are checked offline, so that the full Cartesian dynamics of
+    //! the robot can be used. The elbow is kept at its current position, and appended waypoints are ignored.
+    bool stream_joint_positions {false};
+
+    //! Optimizes the elbow along the path before the motion starts, keeping away from singularities and the joint limits.
+    //! The elbow profile is commanded with the Cartesian poses (or the joint positions), and appended waypoints are ignored.
+    bool optimize_elbow {false};
+
+    //! Precomputed trajectory that is executed instead of planning from the waypoints. It needs to start close to the
+    //! current pose (1 mm and 0.01 rad), and is moved rigidly to start exactly there.
+    std::shared_ptr<const MappedTrajectory> trajectory;
+
+    //! Waypoints appended while the motion is running, shared between all copies of the motion
+    struct AppendQueue {
+        std::mutex mutex;
+        std::vector<std::tuple<std::vector<Waypoint>, double>> pending;
+    };
+    std::shared_ptr<AppendQueue> append_queue {std::make_shared<AppendQueue>()};
+
     explicit PathMotion(const std::vector<Waypoint>& waypoints): waypoints(waypoints) { }
+    explicit PathMotion(const std::vector<Waypoint>& waypoints, Path::Interpolation interpolation): waypoints(waypoints), interpolation(interpolation) { }
+    explicit PathMotion(const std::shared_ptr<const MappedTrajectory>& trajectory): trajectory(trajectory) { }
     explicit PathMotion(const std::vector<Affine>& waypoints, double blend_max_distance = 0.0) {
         this->waypoints.resize(waypoints.size());
         for (size_t i = 0; i < waypoints.size(); i += 1) {
             this->waypoints[i] = Waypoint(waypoints[i], std::nullopt, blend_max_distance);
         }
     }
+
+    //! Appends waypoints to the running motion, blended at the former end with the given distance. The motion continues
+    //! without stopping if the waypoints arrive before the robot needs to brake for the end of the known path. Precomputed
+    //! trajectories are executed unchanged.
+    void append(const std::vector<Waypoint>& waypoints, double blend_max_distance = 0.0) {
+        std::lock_guard<std::mutex> lock {append_queue->mutex};
+        append_queue->pending.emplace_back(waypoints, blend_max_distance);
+    }
 };
 
 
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+#include <movex/waypoint.hpp>
+#include <movex/path/path.hpp>
+
+
+namespace movex {
+
+/**
+ * Chooses the blend distance of each waypoint within a tolerance so that the duration of the path gets minimal. The
+ * duration is predicted from a velocity and acceleration limit per segment, using the maximal path derivatives of the
+ * blend segments, instead of a full time parametrization. The blend distances are optimized one waypoint after the
+ * other (coordinate descent), as a blend influences the possible blends of its neighbors by shortening their lines.
+ */
+class BlendOptimizer {
+    Vector7d max_velocity, max_acceleration, max_jerk;
+
+    //! Returns the maximal path velocity and acceleration on a segment, as the velocity curve of the time parametrization
+    std::tuple<double, double> segment_limits(const Segment& segment) const {
+        const double length = segment.get_length();
+        const Vector7d pdq = segment.pdq(0.0).cwiseAbs().cwiseMax(segment.pdq(length / 2).cwiseAbs()).cwiseMax(segment.pdq(length).cwiseAbs());
+        const Vector7d pddq = segment.max_pddq().cwiseAbs();
+        const Vector7d pdddq = segment.max_pdddq().cwiseAbs();
+
+        const double max_ds = std::min({
+            (max_velocity.array() / pdq.array()).minCoeff(),
+            (max_acceleration.array() / pddq.array()).sqrt().minCoeff(),
+            (max_jerk.array() / pdddq.array()).pow(1./3).minCoeff(),
+        });
+        const double max_dds = (max_acceleration.array() / pdq.array()).minCoeff();
+        return {max_ds, std::max(max_dds, 1e-9)};
+    }
+
+    //! Duration of an acceleration-limited motion over a given length, with entry, exit and maximal velocity
+    static double segment_duration(double length, double ds_start, double ds_end, double max_ds, double max_dds) {
+        const double ds_peak = std::sqrt((2 * max_dds * length + std::pow(ds_start, 2) + std::pow(ds_end, 2)) / 2);
+        if (ds_peak <= max_ds) {
+            return (2 * ds_peak - ds_start - ds_end) / max_dds;
+        }
+
+        const double length_constant = length - (2 * std::pow(max_ds, 2) - std::pow(ds_start, 2) - std::pow(ds_end, 2)) / (2 * max_dds);
+        return (2 * max_ds - ds_start - ds_end) / max_dds + length_constant / max_ds;
+    }
+
+public:
+    //! Number of blend distances per waypoint that are tried in each iteration, equally spaced within the tolerance
+    size_t number_candidates {8};
+
+    //! Number of iterations over all waypoints
+    size_t number_iterations {3};
+
+    explicit BlendOptimizer(const std::array<double, 7>& max_velocity, const std::array<double, 7>& max_acceleration, const std::array<double, 7>& max_jerk) {
+        this->max_velocity = Eigen::Map<const Vector7d>(max_velocity.data());
+        this->max_acceleration = Eigen::Map<const Vector7d>(max_acceleration.data());
+        this->max_jerk = Eigen::Map<const Vector7d>(max_jerk.data());
+    }
+
+    //! Predicts the duration of a motion along the path, starting and ending in standstill
+    double predict_duration(const Path& path) const {
+        const size_t n = path.segments.size();
+
+        std::vector<double> max_ds(n), max_dds(n);
+        for (size_t i = 0; i < n; i += 1) {
+            std::tie(max_ds[i], max_dds[i]) = segment_limits(*path.segments[i]);
+        }
+
+        // Velocity at the segment junctions, zero at the ends and where the path is not continuously differentiable
+        std::vector<double> junction_ds(n + 1, 0.0);
+        for (size_t i = 1; i < n; i += 1) {
+            const auto& left = path.segments[i - 1];
+            const auto& right = path.segments[i];
+            if ((left->pdq(left->get_length()) - right->pdq(0.0)).norm() <= 1e-6) {
+                junction_ds[i] = std::min(max_ds[i - 1], max_ds[i]);
+            }
+        }
+
+        for (size_t i = 1; i <= n; i += 1) {
+            junction_ds[i] = std::min(junction_ds[i], std::sqrt(std::pow(junction_ds[i - 1], 2) + 2 * max_dds[i - 1] * path.segments[i - 1]->get_length()));
+        }
+        for (size_t i = n; i > 0; i -= 1) {
+            junction_ds[i - 1] = std::min(junction_ds[i - 1], std::sqrt(std::pow(junction_ds[i], 2) + 2 * max_dds[i - 1] * path.segments[i - 1]->get_length()));
+        }
+
+        double duration {0.0};
+        for (size_t i = 0; i < n; i += 1) {
+            duration += segment_duration(path.segments[i]->get_length(), junction_ds[i], junction_ds[i + 1], max_ds[i], max_dds[i]);
+        }
+        return duration;
+    }
+
+    //! Returns the waypoints with blend distances between zero and the tolerance that minimize the predicted duration
+    std::vector<Waypoint> optimize(const std::vector<Waypoint>& waypoints, double tolerance) const {
+        auto result = waypoints;
+        if (waypoints.size() < 3 || tolerance <= 0.0) {
+            return result;
+        }
+
+        for (size_t i = 1; i < result.size() - 1; i += 1) {
+            result[i].blend_max_distance = tolerance;
+        }
+
+        double best_duration = predict_duration(Path(result));
+        for (size_t iteration = 0; iteration < number_iterations; iteration += 1) {
+            bool is_improved {false};
+            for (size_t i = 1; i < result.size() - 1; i += 1) {
+                const double current_distance = result[i].blend_max_distance;
+                double best_distance = current_distance;
+
+                for (size_t k = 0; k < number_candidates; k += 1) {
+                    const double distance = tolerance * k / std::max<size_t>(number_candidates - 1, 1);
+                    if (distance == current_distance) {
+                        continue;
+                    }
+
+                    result[i].blend_max_distance = distance;
+                    const double duration = predict_duration(Path(result));
+                    if (duration < best_duration - 1e-9) {
+                        best_duration = duration;
+                        best_distance = distance;
+                        is_improved = true;
+                    }
+                }
+                result[i].blend_max_distance = best_distance;
+            }
+
+            if (!is_improved) {
+                break;
+            }
+        }
+        return result;
+    }
+};
+
+} // namespace movex
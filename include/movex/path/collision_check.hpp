@@ -0,0 +1,131 @@
+#pragma once
+
+#include <array>
+#include <optional>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <movex/affine.hpp>
+#include <movex/path/redundancy_profile.hpp>
+#include <movex/path/trajectory.hpp>
+#include <movex/robot/kinematics.hpp>
+
+
+namespace movex {
+
+/**
+ * Minimum distance queries between a capsule model of the robot and static obstacles, and a continuous collision
+ * check of Cartesian trajectories before their execution. Each link is covered by capsules (and spheres as capsules of
+ * zero length) fixed to its joint frame; the base is not modeled, as it cannot move. Obstacles are half-spaces,
+ * oriented boxes and capsules. Half-spaces and capsules are stored in blocks of four in a structure-of-arrays layout,
+ * so that the distance of a link capsule to a whole block is vectorized. Boxes are calculated one by one. Distances
+ * are between the surfaces, and negative if the geometries intersect.
+ */
+class CollisionCheck {
+public:
+    //! Line segment from start to end, swept by a sphere with the given radius
+    struct Capsule {
+        Eigen::Vector3d start, end;
+        double radius;
+    };
+
+    //! Capsule in the frame of Kinematics::joint_frames with the given index, where 7 is the flange
+    struct LinkCapsule {
+        size_t frame;
+        Capsule capsule;
+    };
+
+    //! State of a trajectory at which the robot comes closer to an obstacle than the minimal distance
+    struct Contact {
+        //! Time of the last state before the contact in [s], and the path position of the contact
+        double t, s;
+
+        //! Distance to the closest obstacle at s in [m]
+        double distance;
+    };
+
+private:
+    constexpr static size_t block_size {4};
+    using Lane = Eigen::Array<double, block_size, 1>;
+
+    //! Half-spaces below the planes n x = offset
+    struct PlaneBlock {
+        std::array<Lane, 3> normal;
+        Lane offset;
+    };
+
+    struct CapsuleBlock {
+        std::array<Lane, 3> start, end;
+        Lane radius;
+    };
+
+    //! Box with the transformation from the base into its frame, its half size and the radius of its bounding sphere
+    struct Box {
+        Eigen::Matrix3d rotation_inverse;
+        Eigen::Vector3d center, half_size;
+        double radius;
+    };
+
+    std::vector<PlaneBlock> planes;
+    std::vector<CapsuleBlock> capsules;
+    std::vector<Box> boxes;
+    size_t plane_count {0}, capsule_count {0};
+
+    //! Distance between the capsule from a to b with radius r and all obstacles
+    double capsule_distance(const Eigen::Vector3d& a, const Eigen::Vector3d& b, double r) const;
+
+public:
+    //! Capsules of the Panda links and the Franka Hand (without its fingers)
+    static std::vector<LinkCapsule> panda_capsules();
+
+    Kinematics kinematics;
+
+    //! Geometric model of the robot, can be extended e.g. by tools attached to the flange
+    std::vector<LinkCapsule> link_capsules {panda_capsules()};
+
+    //! Distance to the obstacles that is treated as contact in [m]
+    double min_distance {0.0};
+
+    //! Distance along s between the coarse samples of the trajectory check
+    double s_step {0.05};
+
+    //! Smallest distance along s to which the trajectory check refines uncertain sections
+    double s_resolution {1e-3};
+
+    //! Position of the last joint along the path, e.g. from the ElbowOptimizer. Otherwise, q7 is kept at its start.
+    std::optional<RedundancyProfile> redundancy;
+
+    explicit CollisionCheck() { }
+    explicit CollisionCheck(const Kinematics& kinematics): kinematics(kinematics) { }
+
+    //! Adds the half-space below the plane with the given normal and offset, e.g. a table
+    void add_plane(const Eigen::Vector3d& normal, double offset);
+
+    //! Adds a box with the given pose of its center and the given size in [m]
+    void add_box(const Affine& pose, const Eigen::Vector3d& size);
+
+    void add_capsule(const Eigen::Vector3d& start, const Eigen::Vector3d& end, double radius);
+
+    void add_sphere(const Eigen::Vector3d& center, double radius) {
+        add_capsule(center, center, radius);
+    }
+
+    void clear_obstacles();
+
+    //! Returns the minimum distance between the robot at the joint positions and all obstacles in [m]
+    double distance(const Vector7d& q) const;
+
+    bool is_colliding(const Vector7d& q) const {
+        return distance(q) < min_distance;
+    }
+
+    //! Returns the first contact when the robot follows the poses of the trajectory (in the given frame) from the joint
+    //! positions q_start, with q7 from the redundancy profile (or constant). The path is sampled every s_step. Between
+    //! two samples, any point of the robot moves at most the sum of the joint differences weighted by its distance to
+    //! the joint axes, so that the section is free if both distances exceed this bound. Otherwise, the section is
+    //! bisected down to s_resolution. Throws if a sampled pose is unreachable.
+    std::optional<Contact> check(const Trajectory& trajectory, const Affine& frame, const Vector7d& q_start) const;
+};
+
+} // namespace movex
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <movex/affine.hpp>
+#include <movex/path/path.hpp>
+#include <movex/path/redundancy_profile.hpp>
+#include <movex/robot/kinematics.hpp>
+
+
+namespace movex {
+
+/**
+ * Optimization of the elbow along a Cartesian path within the null space of the end effector. The redundancy is
+ * parametrized by the last joint q7 (as for the inverse kinematics), so that the elbow position follows from the
+ * joint positions. The profile of q7 is a B-spline with control points every s_step. A dynamic program over a grid of
+ * q7 candidates and the slope between the control points finds the profile with the least integrated cost of low
+ * manipulability, small joint limit margins and fast joint motion along the path, evaluated every s_resolution. The
+ * slope and curvature of the profile are limited exactly by the allowed changes between the control points. The time
+ * parametrization of the path then keeps the resulting joint velocities and accelerations in time, e.g. with a
+ * JointLimitCheck.
+ */
+class ElbowOptimizer {
+public:
+    Kinematics kinematics;
+
+    //! Distance along s between the control points of the profile
+    double s_step {0.1};
+
+    //! Distance along s between the evaluations of the cost
+    double s_resolution {0.01};
+
+    //! Distance between the candidates of q7 in [rad]
+    double q7_step {0.02};
+
+    //! Maximal first and second derivative of q7 with respect to s
+    double max_pdq7 {1.0}, max_pddq7 {4.0};
+
+    //! Weight of the joint limit margin relative to the (logarithmic) manipulability
+    double limit_weight {1.0};
+
+    //! Weight of the squared derivative of the joint positions with respect to s, i.e. the joint velocity at unit path
+    //! velocity
+    double velocity_weight {0.1};
+
+    explicit ElbowOptimizer() { }
+    explicit ElbowOptimizer(const Kinematics& kinematics): kinematics(kinematics) { }
+
+    //! Returns the cost of the joint positions, which grows towards singularities and the joint limits
+    double cost(const Vector7d& q) const;
+
+    //! Returns the profile of q7 along the path (in the given frame), starting from the joint positions q_start. Throws
+    //! if the path cannot be followed with any profile on the same branch of the inverse kinematics.
+    RedundancyProfile optimize(const Path& path, const Affine& frame, const Vector7d& q_start) const;
+};
+
+} // namespace movex
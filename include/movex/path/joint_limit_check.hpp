@@ -0,0 +1,193 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <movex/path/redundancy_profile.hpp>
+#include <movex/path/time_parametrization.hpp>
+#include <movex/path/trajectory.hpp>
+#include <movex/robot/kinematics.hpp>
+
+
+namespace movex {
+
+/**
+ * Checks a Cartesian trajectory against the joint velocity, acceleration and (optionally) jerk limits before its
+ * execution. The path is mapped to joint positions with the inverse kinematics, with q7 from the redundancy profile (or
+ * constant) and choosing the solution closest to the previous state. The joint derivatives along the path then follow
+ * from finite differences in s, and the joint velocity, acceleration and jerk of each state from the chain rule.
+ * Sections of the path that exceed the limits are slowed down locally, instead of reducing the dynamics of the whole
+ * motion.
+ */
+class JointLimitCheck {
+    //! Joint positions and their first, second and third derivative with respect to the path at s
+    struct JointPath {
+        Vector7d q, pdq, pddq, pdddq;
+    };
+
+    //! Distance along s for the finite differences of the joint positions
+    constexpr static double s_difference {1e-4};
+
+    std::optional<JointPath> joint_path(const Path& path, double s, const Affine& frame, double q7_start, const Vector7d& q_reference) const {
+        auto q7 = [&](double s_q7) {
+            return redundancy ? redundancy->q7(s_q7) : q7_start;
+        };
+
+        // Central differences are shifted inwards at the ends of the path
+        const double s_outer = has_jerk_limit() ? 2 * s_difference : s_difference;
+        const double s_center = std::clamp(s, s_outer, path.get_length() - s_outer);
+
+        const auto q = kinematics.inverse(path.pose(s_center, frame), q7(s_center), q_reference);
+        if (!q) {
+            return std::nullopt;
+        }
+        const auto q_before = kinematics.inverse(path.pose(s_center - s_difference, frame), q7(s_center - s_difference), *q);
+        const auto q_after = kinematics.inverse(path.pose(s_center + s_difference, frame), q7(s_center + s_difference), *q);
+        if (!q_before || !q_after) {
+            return std::nullopt;
+        }
+
+        const Vector7d pdq = (*q_after - *q_before) / (2 * s_difference);
+        const Vector7d pddq = (*q_after - 2 * *q + *q_before) / std::pow(s_difference, 2);
+
+        Vector7d pdddq = Vector7d::Zero();
+        if (has_jerk_limit()) {
+            const auto q_before_2 = kinematics.inverse(path.pose(s_center - 2 * s_difference, frame), q7(s_center - 2 * s_difference), *q_before);
+            const auto q_after_2 = kinematics.inverse(path.pose(s_center + 2 * s_difference, frame), q7(s_center + 2 * s_difference), *q_after);
+            if (!q_before_2 || !q_after_2) {
+                return std::nullopt;
+            }
+            pdddq = (*q_after_2 - 2 * *q_after + 2 * *q_before - *q_before_2) / (2 * std::pow(s_difference, 3));
+        }
+        return JointPath {*q + (s - s_center) * pdq, pdq, pddq, pdddq};
+    }
+
+    bool has_jerk_limit() const {
+        return std::isfinite(max_jerk.maxCoeff());
+    }
+
+public:
+    //! Contiguous section of a trajectory that exceeds the joint limits
+    struct Violation {
+        //! Start and end of the section along the path
+        double s_start, s_end;
+
+        //! Maximal ratio of the joint velocity, acceleration and jerk to their limit
+        double velocity_ratio, acceleration_ratio, jerk_ratio;
+
+        //! Path velocity, acceleration and jerk within the section for which the joint limits are kept
+        double max_ds, max_dds, max_ddds;
+    };
+
+    Kinematics kinematics;
+
+    //! Joint limits in [rad/s], [rad/s^2] and [rad/s^3]. The jerk is only checked if its limits are finite.
+    Vector7d max_velocity, max_acceleration, max_jerk {Vector7d::Constant(std::numeric_limits<double>::infinity())};
+
+    //! Position of the last joint along the path, e.g. from the ElbowOptimizer. Otherwise, q7 is kept at its start.
+    std::optional<RedundancyProfile> redundancy;
+
+    //! Fraction of the joint limits that slowed down sections aim for
+    double margin {0.95};
+
+    //! Distance along s by which slowed down sections are extended on both sides
+    double section_extension {0.005};
+
+    //! Maximal number of slow-down and re-parametrization rounds
+    size_t max_iterations {4};
+
+    explicit JointLimitCheck(const Kinematics& kinematics, const std::array<double, 7>& max_velocity, const std::array<double, 7>& max_acceleration): kinematics(kinematics), max_velocity(max_velocity.data()), max_acceleration(max_acceleration.data()) { }
+    explicit JointLimitCheck(const Kinematics& kinematics, const std::array<double, 7>& max_velocity, const std::array<double, 7>& max_acceleration, const std::array<double, 7>& max_jerk): kinematics(kinematics), max_velocity(max_velocity.data()), max_acceleration(max_acceleration.data()), max_jerk(max_jerk.data()) { }
+
+    //! Returns the sections of the trajectory that exceed the joint limits, when the robot follows the poses of the path
+    //! (in the given frame) from the joint positions q_start. Throws if a state is not reachable within the joint limits.
+    std::vector<Violation> check(const Trajectory& trajectory, const Affine& frame, const Vector7d& q_start) const {
+        std::vector<Violation> violations;
+        if (trajectory.path.get_length() < 2 * s_difference) {
+            return violations;
+        }
+
+        bool is_in_violation {false};
+        Vector7d q_last = q_start;
+        const Trajectory::State* previous {nullptr};
+        for (const auto& state: trajectory.states) {
+            // The path jerk of a step includes jumps of the path acceleration, e.g. when the trajectory snaps to a stop
+            double ddds = std::abs(state.ddds);
+            if (previous && state.t > previous->t) {
+                ddds = std::max(ddds, std::abs(state.dds - previous->dds) / (state.t - previous->t));
+            }
+            previous = &state;
+
+            const auto joint = joint_path(trajectory.path, state.s, frame, q_start(6), q_last);
+            if (!joint) {
+                throw std::runtime_error("Pose at t = " + std::to_string(state.t) + " s is not reachable within the joint limits.");
+            }
+            q_last = joint->q;
+
+            // Chain rule: dq = pdq ds, ddq = pddq ds^2 + pdq dds, dddq = pdddq ds^3 + 3 pddq ds dds + pdq ddds
+            const Vector7d pdq = joint->pdq.cwiseAbs(), pddq = joint->pddq.cwiseAbs(), pdddq = joint->pdddq.cwiseAbs();
+            const double velocity_ratio = (pdq.array() * state.ds / max_velocity.array()).maxCoeff();
+            const double acceleration_ratio = ((pddq.array() * std::pow(state.ds, 2) + pdq.array() * std::abs(state.dds)) / max_acceleration.array()).maxCoeff();
+            const double jerk_ratio = ((pdddq.array() * std::pow(state.ds, 3) + 3 * pddq.array() * state.ds * std::abs(state.dds) + pdq.array() * ddds) / max_jerk.array()).maxCoeff();
+            if (velocity_ratio <= 1.0 && acceleration_ratio <= 1.0 && jerk_ratio <= 1.0) {
+                is_in_violation = false;
+                continue;
+            }
+
+            // The section limits bound the path velocity, acceleration and jerk independently of each other, so the
+            // acceleration limit is split between both terms of the chain rule and the jerk limit between its three terms
+            const double max_ds = std::min({
+                (margin * max_velocity.array() / pdq.array()).minCoeff(),
+                (margin * max_acceleration.array() / (2 * pddq.array())).sqrt().minCoeff(),
+                (margin * max_jerk.array() / (3 * pdddq.array())).pow(1.0 / 3).minCoeff(),
+            });
+            const double max_dds = std::min(
+                ((margin * max_acceleration.array() - pddq.array() * std::pow(max_ds, 2)) / pdq.array()).minCoeff(),
+                (margin * max_jerk.array() / (9 * pddq.array() * max_ds)).minCoeff()
+            );
+            const double max_ddds = ((margin * max_jerk.array() - pdddq.array() * std::pow(max_ds, 3) - 3 * pddq.array() * max_ds * max_dds) / pdq.array()).minCoeff();
+
+            if (!is_in_violation) {
+                violations.push_back({state.s, state.s, 0.0, 0.0, 0.0, max_ds, max_dds, max_ddds});
+                is_in_violation = true;
+            }
+
+            auto& violation = violations.back();
+            violation.s_end = state.s;
+            violation.velocity_ratio = std::max(violation.velocity_ratio, velocity_ratio);
+            violation.acceleration_ratio = std::max(violation.acceleration_ratio, acceleration_ratio);
+            violation.jerk_ratio = std::max(violation.jerk_ratio, jerk_ratio);
+            violation.max_ds = std::min(violation.max_ds, max_ds);
+            violation.max_dds = std::min(violation.max_dds, max_dds);
+            violation.max_ddds = std::min(violation.max_ddds, max_ddds);
+        }
+        return violations;
+    }
+
+    //! Returns the time parametrization of the Cartesian path, slowed down within all sections that exceed the joint
+    //! limits. The limits might still be exceeded after the maximal number of iterations, e.g. close to singularities.
+    Trajectory parametrize(TimeParametrization parametrization, const Path& path, const Affine& frame, const Vector7d& q_start, const std::array<double, 7>& max_path_velocity, const std::array<double, 7>& max_path_acceleration, const std::array<double, 7>& max_path_jerk) const {
+        Trajectory trajectory = parametrization.parametrize(path, max_path_velocity, max_path_acceleration, max_path_jerk);
+
+        for (size_t i = 0; i < max_iterations; i += 1) {
+            const auto violations = check(trajectory, frame, q_start);
+            if (violations.empty()) {
+                break;
+            }
+
+            for (const auto& violation: violations) {
+                parametrization.section_limits.push_back({violation.s_start - section_extension, violation.s_end + section_extension, violation.max_ds, violation.max_dds, violation.max_ddds});
+            }
+            trajectory = parametrization.parametrize(path, max_path_velocity, max_path_acceleration, max_path_jerk);
+        }
+        return trajectory;
+    }
+};
+
+} // namespace movex
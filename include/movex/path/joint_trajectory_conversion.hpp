@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <movex/path/redundancy_profile.hpp>
+#include <movex/path/trajectory.hpp>
+#include <movex/robot/kinematics.hpp>
+
+
+namespace movex {
+
+/**
+ * Conversion of a parametrized Cartesian trajectory to the joint positions of each of its states, so that the robot
+ * follows it with joint position commands instead of its internal inverse kinematics. Each pose is mapped with the
+ * inverse kinematics, with q7 from the redundancy profile (or constant) and choosing the solution closest to the
+ * previous state, so that the elbow stays on one branch. The joint positions are then checked against the velocity,
+ * acceleration and jerk limits with finite differences, including the standstill before and after the trajectory.
+ */
+class JointTrajectoryConversion {
+    //! Checks the backward differences of the joint positions, with the standstill before and after the trajectory
+    void check_limits(const Trajectory& trajectory, const std::vector<Vector7d>& q) const {
+        const size_t n = q.size();
+        if (n < 2) {
+            return;
+        }
+
+        // Two further steps at the final joint positions, so that the robot comes to a standstill
+        const double last_step = trajectory.states[n - 1].t - trajectory.states[n - 2].t;
+        auto position = [&](size_t i) -> const Vector7d& {
+            return q[std::min(i, n - 1)];
+        };
+        auto time = [&](size_t i) {
+            return (i < n) ? trajectory.states[i].t : trajectory.states[n - 1].t + (i - n + 1) * last_step;
+        };
+
+        auto check = [](const Vector7d& values, const Vector7d& limits, const std::string& name, double t) {
+            for (size_t j = 0; j < 7; j += 1) {
+                if (std::abs(values(j)) > limits(j)) {
+                    throw std::runtime_error("Joint " + std::to_string(j + 1) + " exceeds its " + name + " limit at t = " + std::to_string(t) + " s.");
+                }
+            }
+        };
+
+        Vector7d velocity = Vector7d::Zero(), acceleration = Vector7d::Zero();
+        for (size_t i = 1; i < n + 2; i += 1) {
+            const double delta_time = time(i) - time(i - 1);
+            if (delta_time <= 0.0) {
+                continue;
+            }
+
+            const Vector7d new_velocity = (position(i) - position(i - 1)) / delta_time;
+            const Vector7d new_acceleration = (new_velocity - velocity) / delta_time;
+            const Vector7d jerk = (new_acceleration - acceleration) / delta_time;
+            velocity = new_velocity;
+            acceleration = new_acceleration;
+
+            check(velocity, max_velocity, "velocity", time(i));
+            check(acceleration, max_acceleration, "acceleration", time(i));
+            check(jerk, max_jerk, "jerk", time(i));
+        }
+    }
+
+public:
+    Kinematics kinematics;
+
+    //! Joint limits in [rad/s], [rad/s^2] and [rad/s^3]
+    Vector7d max_velocity, max_acceleration, max_jerk;
+
+    //! Position of the last joint along the path, e.g. from the ElbowOptimizer. Otherwise, q7 is kept at its start.
+    std::optional<RedundancyProfile> redundancy;
+
+    //! Maximal difference between the inverse kinematics of the start pose and the start joint positions in [rad]. A
+    //! smaller difference is faded out linearly over the trajectory, so that it starts exactly at q_start.
+    double start_tolerance {1e-3};
+
+    explicit JointTrajectoryConversion(const Kinematics& kinematics, const std::array<double, 7>& max_velocity, const std::array<double, 7>& max_acceleration, const std::array<double, 7>& max_jerk): kinematics(kinematics), max_velocity(max_velocity.data()), max_acceleration(max_acceleration.data()), max_jerk(max_jerk.data()) { }
+
+    //! Returns the joint positions for each state of the trajectory, when the robot follows the poses of the path (in
+    //! the given frame) from the joint positions q_start. Throws if a pose is unreachable or a joint limit is exceeded.
+    std::vector<Vector7d> convert(const Trajectory& trajectory, const Affine& frame, const Vector7d& q_start) const {
+        std::vector<Vector7d> result;
+        result.reserve(trajectory.states.size());
+
+        Vector7d q_last = q_start;
+        for (const auto& state: trajectory.states) {
+            const double q7 = redundancy ? redundancy->q7(state.s) : q_start(6);
+            const auto q = kinematics.inverse(trajectory.path.pose(state.s, frame), q7, q_last);
+            if (!q) {
+                throw std::runtime_error("Pose at t = " + std::to_string(state.t) + " s is not reachable within the joint limits.");
+            }
+            result.push_back(*q);
+            q_last = *q;
+        }
+
+        if (result.empty()) {
+            return result;
+        }
+
+        const Vector7d start_difference = q_start - result.front();
+        if (start_difference.cwiseAbs().maxCoeff() > start_tolerance) {
+            throw std::runtime_error("Trajectory does not start at the given joint positions.");
+        }
+        for (size_t i = 0; i < result.size(); i += 1) {
+            result[i] += start_difference * (result.size() - i - 1) / std::max<double>(result.size() - 1, 1.0);
+        }
+
+        check_limits(trajectory, result);
+        return result;
+    }
+};
+
+} // namespace movex
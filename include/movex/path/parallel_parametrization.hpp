@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include <movex/waypoint.hpp>
+#include <movex/path/path.hpp>
+#include <movex/path/time_parametrization.hpp>
+#include <movex/path/trajectory.hpp>
+
+
+namespace movex {
+
+/**
+ * Parametrizes many candidate paths concurrently and returns the fastest one. Candidates might differ in their blend
+ * distances, waypoint order or limits. The threads take the next candidate from a shared counter, so that they stay
+ * busy regardless of the duration of each parametrization, and abort a candidate as soon as it gets slower than the
+ * best trajectory found so far.
+ */
+class ParallelParametrization {
+    TimeParametrization parametrization;
+
+public:
+    struct Candidate {
+        std::vector<Waypoint> waypoints;
+        Path::Interpolation interpolation;
+        std::array<double, 7> max_velocity, max_acceleration, max_jerk;
+
+        explicit Candidate(const std::vector<Waypoint>& waypoints, Path::Interpolation interpolation, const std::array<double, 7>& max_velocity, const std::array<double, 7>& max_acceleration, const std::array<double, 7>& max_jerk): waypoints(waypoints), interpolation(interpolation), max_velocity(max_velocity), max_acceleration(max_acceleration), max_jerk(max_jerk) { }
+    };
+
+    struct Result {
+        //! Index of the fastest candidate
+        size_t index;
+
+        Trajectory trajectory;
+    };
+
+    //! Number of threads, including the calling one
+    size_t number_threads;
+
+    explicit ParallelParametrization(double delta_time, size_t number_threads = std::max(std::thread::hardware_concurrency(), 1u)): parametrization(delta_time), number_threads(number_threads) { }
+
+    //! Returns the fastest trajectory of all candidates, candidates without a valid path are skipped
+    std::optional<Result> fastest(const std::vector<Candidate>& candidates) const {
+        std::atomic<size_t> next_index {0};
+        std::atomic<double> best_duration {std::numeric_limits<double>::infinity()};
+
+        std::mutex best_mutex;
+        std::optional<Result> best;
+
+        auto work = [&]() {
+            for (size_t index = next_index++; index < candidates.size(); index = next_index++) {
+                const auto& candidate = candidates[index];
+
+                std::optional<Path> path;
+                try {
+                    path.emplace(candidate.waypoints, candidate.interpolation);
+                } catch (const std::runtime_error&) {
+                    continue;
+                }
+
+                TimeParametrization candidate_parametrization {parametrization};
+                candidate_parametrization.lookahead = path->get_length();
+                auto stream = candidate_parametrization.stream(*path, candidate.max_velocity, candidate.max_acceleration, candidate.max_jerk);
+
+                Trajectory trajectory {*path};
+                trajectory.states.push_back(stream.get_state());
+                bool is_slower {false};
+                while (!stream.is_finished() && !is_slower) {
+                    trajectory.states.push_back(stream.step());
+                    is_slower = (trajectory.states.back().t > best_duration.load());
+                }
+                if (is_slower) {
+                    continue;
+                }
+
+                // Prefer the lower index for equally fast candidates, so that the result does not depend on the scheduling
+                const double duration = trajectory.states.back().t;
+                std::lock_guard<std::mutex> lock {best_mutex};
+                if (!best || duration < best_duration || (duration == best_duration && index < best->index)) {
+                    best_duration = duration;
+                    best.emplace(Result {index, std::move(trajectory)});
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < std::min(number_threads, candidates.size()); i += 1) {
+            threads.emplace_back(work);
+        }
+        work();
+
+        for (auto& thread: threads) {
+            thread.join();
+        }
+        return best;
+    }
+};
+
+} // namespace movex
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <iostream>
+#include <limits>
 #include <memory>
 
 #include <Eigen/Core>
@@ -17,22 +18,66 @@ class Path {
 
     double length {0.0};
 
+    static std::vector<Waypoint> convert_affines(const std::vector<Affine>& affines, double blend_max_distance);
+    static std::vector<Vector7d> get_target_vectors(const std::vector<Waypoint>& waypoints);
+
+    void add_segment(const std::shared_ptr<Segment>& segment);
+    void add_blended_lines(std::vector<std::shared_ptr<LineSegment>> line_segments, const std::vector<double>& blend_max_distances, double first_s_abs_max);
+    void init_lines(const std::vector<Vector7d>& vectors, const std::vector<double>& blend_max_distances);
     void init_path_points(const std::vector<Waypoint>& waypoints);
+    void init_quintic_spline(const std::vector<Waypoint>& waypoints);
+    void init_slerp(const std::vector<Waypoint>& waypoints);
+
+    //! Evaluates f(segment, s_local, i) for each s(i), walking along the segments as long as s is sorted
+    template<class F>
+    Eigen::Matrix<double, 7, Eigen::Dynamic> evaluate(const Eigen::VectorXd& s, F f) const;
 
 public:
+    //! How the path is interpolated between its waypoints
+    enum class Interpolation {
+        //! Line segments, blended at the waypoints according to their blend_max_distance
+        Linear,
+
+        //! Curvature-continuous quintic spline through all waypoints
+        QuinticSpline,
+
+        //! Straight lines with spherical linear interpolation of the orientation, stopping at each waypoint without blending
+        Slerp,
+    };
+
     constexpr static size_t degrees_of_freedom {7};
 
     std::vector<std::shared_ptr<Segment>> segments;
     size_t get_index(double s) const;
     std::tuple<std::shared_ptr<Segment>, double> get_local(double s) const;
 
-    explicit Path(const std::vector<Waypoint>& waypoints);
+    explicit Path(const std::vector<Waypoint>& waypoints, Interpolation interpolation = Interpolation::Linear);
     explicit Path(const std::vector<Affine>& waypoints, double blend_max_distance = 0.0);
+    explicit Path(const std::vector<Affine>& waypoints, Interpolation interpolation);
+    explicit Path(const std::vector<std::shared_ptr<Segment>>& segments);
+
+    //! Path with blended lines directly through the given vectors without any conversion, e.g. joint positions for a
+    //! path in joint space. The blend distance is then given in the joint space as well.
+    explicit Path(const std::vector<Vector7d>& vectors, double blend_max_distance = 0.0);
+
+    //! Reduces dense waypoints (e.g. from CAD or vision) to the ones needed to stay within the given Cartesian and
+    //! angular deviation from the original polyline, using the Douglas-Peucker algorithm. The elbow deviation is
+    //! limited by the angular tolerance. Kept waypoints are converted to absolute ones with their blend distance.
+    static std::vector<Waypoint> simplify(const std::vector<Waypoint>& waypoints, double max_translation_deviation, double max_rotation_deviation);
 
     double get_length() const;
 
+    //! Appends waypoints to the end of the path. A final line is blended into the new ones with the given distance,
+    //! the path before s_fixed stays unchanged. A final slerp segment is continued with slerp segments without blending.
+    void append(const std::vector<Waypoint>& waypoints, double blend_max_distance = 0.0, double s_fixed = 0.0);
+
     Vector7d q(double s) const;
     Vector7d q(double s, const Affine& frame) const;
+
+    //! Cartesian pose at s, without the conversion to and from Euler angles of q for slerp segments
+    Affine pose(double s) const;
+    Affine pose(double s, const Affine& frame) const;
+
     Vector7d pdq(double s) const;
     Vector7d pddq(double s) const;
     Vector7d pdddq(double s) const;
@@ -43,6 +88,16 @@ public:
 
     Vector7d max_pddq() const;
     Vector7d max_pdddq() const;
+
+    //! Batch evaluation at many (preferably sorted) positions, returns one column per position
+    Eigen::Matrix<double, 7, Eigen::Dynamic> q(const Eigen::VectorXd& s) const;
+    Eigen::Matrix<double, 7, Eigen::Dynamic> pdq(const Eigen::VectorXd& s) const;
+    Eigen::Matrix<double, 7, Eigen::Dynamic> pddq(const Eigen::VectorXd& s) const;
+    Eigen::Matrix<double, 7, Eigen::Dynamic> pdddq(const Eigen::VectorXd& s) const;
+
+    Eigen::Matrix<double, 7, Eigen::Dynamic> dq(const Eigen::VectorXd& s, const Eigen::VectorXd& ds) const;
+    Eigen::Matrix<double, 7, Eigen::Dynamic> ddq(const Eigen::VectorXd& s, const Eigen::VectorXd& ds, const Eigen::VectorXd& dds) const;
+    Eigen::Matrix<double, 7, Eigen::Dynamic> dddq(const Eigen::VectorXd& s, const Eigen::VectorXd& ds, const Eigen::VectorXd& dds, const Eigen::VectorXd& ddds) const;
 };
 
 } // namespace movex
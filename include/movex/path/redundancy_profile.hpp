@@ -0,0 +1,46 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+
+namespace movex {
+
+/**
+ * Position of the last joint q7 along a path, which resolves the redundancy of the inverse kinematics. The profile is a
+ * uniform cubic B-spline over s, so that the joint positions have a continuous second derivative along the path. Its
+ * slope and curvature are bounded by the first and second differences of the control points.
+ */
+struct RedundancyProfile {
+    //! Distance along s between the control points
+    double s_step;
+
+    //! Control points, of which the first and the last one lie before the start and after the end of the path
+    std::vector<double> control_points;
+
+    //! Profile close to the given samples at s = i s_step. The outer control points mirror the second sample at the first
+    //! one (and the second to last at the last one), so that the profile passes exactly through both ends.
+    explicit RedundancyProfile(double s_step, const std::vector<double>& samples): s_step(s_step) {
+        if (samples.size() < 2) {
+            throw std::runtime_error("Redundancy profile needs at least two samples.");
+        }
+
+        control_points.reserve(samples.size() + 2);
+        control_points.push_back(2 * samples[0] - samples[1]);
+        control_points.insert(control_points.end(), samples.begin(), samples.end());
+        control_points.push_back(2 * samples[samples.size() - 1] - samples[samples.size() - 2]);
+    }
+
+    //! Returns q7 at s, which is clamped to the range of the samples
+    double q7(double s) const {
+        const double x = std::clamp(s / s_step, 0.0, double(control_points.size() - 3));
+        const size_t i = std::min<size_t>(x, control_points.size() - 4);
+        const double u = x - i;
+        const double* c = control_points.data() + i;
+        return (std::pow(1 - u, 3) * c[0] + ((3 * u - 6) * u * u + 4) * c[1] + (((-3 * u + 3) * u + 3) * u + 1) * c[2] + std::pow(u, 3) * c[3]) / 6;
+    }
+};
+
+} // namespace movex
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <array>
+#include <cmath>
 #include <memory>
 
 #include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <movex/affine.hpp>
 
 
 namespace movex {
@@ -32,6 +37,11 @@ struct Segment {
 
     virtual Vector7d max_pddq() const = 0;
     virtual Vector7d max_pdddq() const = 0;
+
+    //! Cartesian pose at s, segments with an orientation representation other than Euler angles override this
+    virtual Affine pose(double s) const {
+        return Affine(q(s));
+    }
 };
 
 
@@ -81,7 +91,155 @@ class CircleSegment: public Segment {
 
 
 class QuinticSegment: public Segment {
+    //! Maximum absolute value of the polynomial c0 + c1 s + c2 s^2 + c3 s^3 on [0, length] for each dimension
+    Vector7d max_abs_cubic(const Vector7d& c0, const Vector7d& c1, const Vector7d& c2, const Vector7d& c3) const {
+        Vector7d result;
+        for (size_t i = 0; i < 7; i += 1) {
+            auto value = [&](double s) { return std::abs(c0(i) + s * (c1(i) + s * (c2(i) + s * c3(i)))); };
+            double max = std::max(value(0.0), value(length));
+
+            // Extrema at the roots of the derivative c1 + 2 c2 s + 3 c3 s^2
+            const double qa = 3 * c3(i), qb = 2 * c2(i), qc = c1(i);
+            if (std::abs(qa) > 1e-12) {
+                const double discriminant = qb * qb - 4 * qa * qc;
+                if (discriminant >= 0.0) {
+                    for (double root: {(-qb + std::sqrt(discriminant)) / (2 * qa), (-qb - std::sqrt(discriminant)) / (2 * qa)}) {
+                        if (0.0 < root && root < length) {
+                            max = std::max(max, value(root));
+                        }
+                    }
+                }
+            } else if (std::abs(qb) > 1e-12) {
+                const double root = -qc / qb;
+                if (0.0 < root && root < length) {
+                    max = std::max(max, value(root));
+                }
+            }
+            result(i) = max;
+        }
+        return result;
+    }
+
+public:
+    //! Polynomial coefficients q(s) = c0 + c1 s + c2 s^2 + c3 s^3 + c4 s^4 + c5 s^5
+    Vector7d c0, c1, c2, c3, c4, c5;
+
+    //! Quintic Hermite segment with given position, first and second path derivative at both ends
+    //! Quintic segment with given polynomial coefficients
+    explicit QuinticSegment(const std::array<Vector7d, 6>& coefficients, double length): c0(coefficients[0]), c1(coefficients[1]), c2(coefficients[2]), c3(coefficients[3]), c4(coefficients[4]), c5(coefficients[5]) {
+        this->length = length;
+    }
+
+    explicit QuinticSegment(const Vector7d& start, const Vector7d& start_pdq, const Vector7d& start_pddq, const Vector7d& end, const Vector7d& end_pdq, const Vector7d& end_pddq, double length) {
+        this->length = length;
+        const double l2 = std::pow(length, 2), l3 = std::pow(length, 3);
+
+        c0 = start;
+        c1 = start_pdq;
+        c2 = start_pddq / 2;
+        c3 = (20 * (end - start) - (8 * end_pdq + 12 * start_pdq) * length - (3 * start_pddq - end_pddq) * l2) / (2 * l3);
+        c4 = (30 * (start - end) + (14 * end_pdq + 16 * start_pdq) * length + (3 * start_pddq - 2 * end_pddq) * l2) / (2 * l3 * length);
+        c5 = (12 * (end - start) - 6 * (end_pdq + start_pdq) * length - (start_pddq - end_pddq) * l2) / (2 * l3 * l2);
+    }
+
+    double get_length() const {
+        return length;
+    }
+
+    Vector7d q(double s) const {
+        return c0 + s * (c1 + s * (c2 + s * (c3 + s * (c4 + s * c5))));
+    }
+
+    Vector7d pdq(double s) const {
+        return c1 + s * (2 * c2 + s * (3 * c3 + s * (4 * c4 + s * 5 * c5)));
+    }
+
+    Vector7d pddq(double s) const {
+        return 2 * c2 + s * (6 * c3 + s * (12 * c4 + s * 20 * c5));
+    }
+
+    Vector7d pdddq(double s) const {
+        return 6 * c3 + s * (24 * c4 + s * 60 * c5);
+    }
+
+    Vector7d max_pddq() const {
+        return max_abs_cubic(2 * c2, 6 * c3, 12 * c4, 20 * c5);
+    }
+
+    Vector7d max_pdddq() const {
+        return max_abs_cubic(6 * c3, 24 * c4, 60 * c5, Vector7d::Zero());
+    }
+};
+
+
+/**
+ * Straight line in translation and elbow, and rotation about a constant axis (spherical linear interpolation) in
+ * orientation. The rotational path derivatives are the angular velocity in the start frame per path length, and the
+ * rotation angle contributes to the path length like a translation.
+ */
+class SlerpSegment: public Segment {
+    //! Rotation axis (in the start frame) and angle from start to end orientation
+    Eigen::Vector3d axis;
+    double angle;
 
+    Eigen::Quaterniond rotation(double s) const {
+        return start_rotation * Eigen::Quaterniond(Eigen::AngleAxisd(angle * s / length, axis));
+    }
+
+public:
+    Eigen::Vector3d start_translation, end_translation;
+    Eigen::Quaterniond start_rotation, end_rotation;
+    double start_elbow, end_elbow;
+
+    explicit SlerpSegment(const Eigen::Vector3d& start_translation, const Eigen::Quaterniond& start_rotation, double start_elbow, const Eigen::Vector3d& end_translation, const Eigen::Quaterniond& end_rotation, double end_elbow): start_translation(start_translation), end_translation(end_translation), start_rotation(start_rotation), end_rotation(end_rotation), start_elbow(start_elbow), end_elbow(end_elbow) {
+        // Rotate the shorter way around
+        Eigen::Quaterniond difference = start_rotation.conjugate() * end_rotation;
+        if (difference.w() < 0.0) {
+            difference.coeffs() *= -1;
+        }
+
+        const Eigen::AngleAxisd angle_axis {difference.normalized()};
+        angle = angle_axis.angle();
+        axis = (angle > 0.0) ? angle_axis.axis() : Eigen::Vector3d::UnitZ();
+
+        length = std::sqrt((end_translation - start_translation).squaredNorm() + std::pow(angle, 2) + std::pow(end_elbow - start_elbow, 2));
+    }
+
+    double get_length() const {
+        return length;
+    }
+
+    Vector7d q(double s) const {
+        return pose(s).vector_with_elbow(start_elbow + s / length * (end_elbow - start_elbow));
+    }
+
+    Vector7d pdq(double s) const {
+        Vector7d result;
+        result << (end_translation - start_translation) / length, axis * angle / length, (end_elbow - start_elbow) / length;
+        return result;
+    }
+
+    Vector7d pddq(double s) const {
+        return Vector7d::Zero();
+    }
+
+    Vector7d pdddq(double s) const {
+        return Vector7d::Zero();
+    }
+
+    Vector7d max_pddq() const {
+        return Vector7d::Zero();
+    }
+
+    Vector7d max_pdddq() const {
+        return Vector7d::Zero();
+    }
+
+    Affine pose(double s) const {
+        Affine::Type result {rotation(s)};
+        result.translation() = start_translation + s / length * (end_translation - start_translation);
+        return Affine(result);
+    }
 };
 
 
@@ -116,6 +274,11 @@ public:
         f = lb.array() + lm.array()*(-s_abs_min + s_mid);
     }
 
+    //! Quartic blend with given polynomial coefficients and the left and right lines
+    explicit QuarticBlendSegment(double s_length, const Vector7d& b, const Vector7d& c, const Vector7d& e, const Vector7d& f, const Vector7d& lb, const Vector7d& lm, const Vector7d& rb, const Vector7d& rm): s_length(s_length), b(b), c(c), e(e), f(f), lb(lb), lm(lm), rb(rb), rm(rm) {
+        length = s_length;
+    }
+
     double get_length() const {
         return s_length;
     }
@@ -1,122 +1,845 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <optional>
+
 #include <movex/otg/ruckig.hpp>
 #include <movex/path/trajectory.hpp>
 
 
 namespace movex {
 
+/**
+ * Time-optimal, jerk-limited time parametrization of a path. First, the limits of the path velocity, acceleration and
+ * jerk are sampled along s, and the velocity curve is limited by a forward and backward integration of the path
+ * acceleration. Then, the trajectory is smoothed by a jerk-limited generator that applies the maximal jerk for which
+ * it can still brake to standstill below the velocity curve and before the next stop of the path. The available path
+ * acceleration and jerk are calculated from the actual path velocity and acceleration. For braking, they are taken
+ * as minimum over the braking distance, so that the generator slows down in time for restrictive segments.
+ */
 class TimeParametrization {
-    std::unique_ptr<Ruckig<1>> otg;
+    //! Sampled quantity along s with range-minimum queries, keeping only the latest samples up to its capacity
+    struct SampledCurve {
+        double s_step;
+
+        //! Indices of the samples in memory, the sample i is at i s_step
+        size_t index_begin, index_end;
+
+        //! min_table[level][i & mask] is the minimum of the samples [i, i + 2^level), as ring buffer over the indices
+        size_t mask;
+        std::vector<std::vector<double>> min_table;
+
+        explicit SampledCurve(double s_step, size_t index_begin, size_t capacity): s_step(s_step), index_begin(index_begin), index_end(index_begin) {
+            size_t size {1};
+            while (size < capacity) {
+                size *= 2;
+            }
+            mask = size - 1;
+
+            for (size_t width = 1; width <= size; width *= 2) {
+                min_table.emplace_back(size);
+            }
+        }
+
+        //! Appends the next sample, and drops the oldest one if the capacity is reached
+        void push_back(double value) {
+            min_table[0][index_end & mask] = value;
+            index_end += 1;
+            index_begin = std::max(index_begin, index_end - std::min(index_end, mask + 1));
+
+            for (size_t level = 1, width = 2; level < min_table.size() && width <= index_end - index_begin; level += 1, width *= 2) {
+                const size_t i = index_end - width;
+                min_table[level][i & mask] = std::min(min_table[level - 1][i & mask], min_table[level - 1][(i + width / 2) & mask]);
+            }
+        }
+
+        //! Linear interpolation of the samples at s
+        double at(double s) const {
+            const auto& values = min_table[0];
+            const double index = std::clamp(s / s_step, double(index_begin), double(index_end - 1));
+            if (index_end - index_begin < 2) {
+                return values[index_begin & mask];
+            }
+            const size_t left = std::min<size_t>(index, index_end - 2);
+            return values[left & mask] + (index - left) * (values[(left + 1) & mask] - values[left & mask]);
+        }
+
+        //! Level and table positions of the minimum between s_min and s_max, including the enclosing samples. The
+        //! position is the same for all curves sampled along the same window.
+        std::array<size_t, 3> min_position(double s_min, double s_max) const {
+            const size_t left = std::clamp<double>(std::floor(s_min / s_step), index_begin, index_end - 1);
+            const size_t right = std::clamp<double>(std::ceil(s_max / s_step), left, index_end - 1);
+            size_t level {0};
+            while ((size_t(2) << level) <= right - left + 1) {
+                level += 1;
+            }
+            return {level, left & mask, (right + 1 - (size_t(1) << level)) & mask};
+        }
+
+        double min(const std::array<size_t, 3>& position) const {
+            const auto& level = min_table[position[0]];
+            return std::min(level[position[1]], level[position[2]]);
+        }
+
+        //! Minimal value between s_min and s_max, including the enclosing samples
+        double min(double s_min, double s_max) const {
+            return min(min_position(s_min, s_max));
+        }
+    };
+
+    /**
+     * Limits of the path velocity, acceleration and jerk along s. With the chain rule ddq = pddq ds^2 + pdq dds and
+     * dddq = pdddq ds^3 + 3 pddq ds dds + pdq ddds, all joint-axis limits are kept at s by the (conservative) conditions
+     *   ds <= velocity, (ds / curvature)^2 + |dds| / acceleration <= 1 and
+     *   (ds / curvature)^3 + ds |dds| / cross + |ddds| / jerk <= 1,
+     * so that the available path acceleration and jerk depend on the actual path velocity and acceleration.
+     */
+    struct PathLimits {
+        //! Maximal path velocity for zero path acceleration
+        SampledCurve velocity;
+
+        //! Path velocity at which the curvature terms pddq ds^2 and pdddq ds^3 alone reach the joint-axis limits
+        SampledCurve curvature;
+
+        //! Product ds |dds| at which the cross term 3 pddq ds dds alone reaches the jerk limits
+        SampledCurve cross;
+
+        //! Maximal path acceleration and jerk for zero path velocity
+        SampledCurve acceleration, jerk;
+    };
 
     //! Time step between updates (cycle time) in [s]
     const double delta_time;
 
-    double intersection(double s1, double ds1, double s2, double ds2, double max_ds, double max_dds, double max_ddds) {
+    //! Joint-axis limits of the current parametrization
+    Vector7d max_velocity_v, max_acceleration_v, max_jerk_v;
 
+    //! Maximal path acceleration at the given path velocity, from the curvature, cross and acceleration limits
+    static double max_acceleration_at(double ds, double curvature, double cross, double acceleration) {
+        const double max_dds = acceleration * std::max(1.0 - std::pow(ds / curvature, 2), 0.0);
+        return (ds > 0.0) ? std::min(max_dds, cross * std::max(1.0 - std::pow(ds / curvature, 3), 0.0) / ds) : max_dds;
     }
 
-    std::tuple<double, double> max_dynamics(double s_start, double ds_start, double max_ds, double max_dds, double max_ddds) {
+    //! Absolute path derivatives at a sample, as maximum over all evaluations assigned to it
+    struct SampleDerivatives {
+        Vector7d pdq {Vector7d::Zero()}, pddq {Vector7d::Zero()}, pdddq {Vector7d::Zero()};
+
+        void add(const Segment& segment, double s_local) {
+            pdq = pdq.cwiseMax(segment.pdq(s_local).cwiseAbs());
+            pddq = pddq.cwiseMax(segment.pddq(s_local).cwiseAbs());
+            pdddq = pdddq.cwiseMax(segment.pdddq(s_local).cwiseAbs());
+        }
+    };
+
+    //! Path limits at a single sample, see PathLimits
+    struct LimitSample {
+        double velocity, curvature, cross, acceleration, jerk;
+    };
 
+    //! Path acceleration from the velocity curve at one sample towards the next one, with the limits of both
+    static double acceleration_between(const LimitSample& from, const LimitSample& to) {
+        return std::min(max_acceleration_at(from.velocity, from.curvature, from.cross, from.acceleration), max_acceleration_at(from.velocity, to.curvature, to.cross, to.acceleration));
     }
 
-public:
-    TimeParametrization(double delta_time): delta_time(delta_time) {
-        otg = std::make_unique<Ruckig<1>>(delta_time);
+    //! Returns the path limits of the sample with the given index from the path derivatives at the sample and its neighbors
+    LimitSample bound_sample(size_t index, double s_step, const SampleDerivatives& left, const SampleDerivatives& sample, const SampleDerivatives& right) const {
+        // The velocity curve is kept slightly below the sampled limit for numerical robustness
+        constexpr double sampling_margin {1e-5};
+
+        // The acceleration and jerk limits between two samples are taken as minimum of both, so each sample bounds the
+        // derivatives up to its neighbors, using the next higher derivative for the change in between. The velocity curve
+        // is only a target of the generator and follows the sampled derivatives directly.
+        const Vector7d pdddq_bound = left.pdddq.cwiseMax(sample.pdddq).cwiseMax(right.pdddq);
+        const Vector7d pddq_bound = left.pddq.cwiseMax(sample.pddq).cwiseMax(right.pddq) + s_step / 2 * pdddq_bound;
+        const Vector7d pdq_bound = left.pdq.cwiseMax(sample.pdq).cwiseMax(right.pdq) + s_step / 2 * pddq_bound;
+
+        LimitSample limits;
+        limits.curvature = std::min(
+            (max_acceleration_v.array() / pddq_bound.array()).sqrt().minCoeff(),
+            (max_jerk_v.array() / pdddq_bound.array()).pow(1.0 / 3).minCoeff()
+        );
+        limits.cross = (max_jerk_v.array() / (3 * pddq_bound.array())).minCoeff();
+        limits.acceleration = (max_acceleration_v.array() / pdq_bound.array()).minCoeff();
+        limits.jerk = (max_jerk_v.array() / pdq_bound.array()).minCoeff();
+        limits.velocity = (1.0 - sampling_margin) * std::min({
+            (max_velocity_v.array() / sample.pdq.array()).minCoeff(),
+            max_tool_velocity / sample.pdq.head<3>().norm(),
+            (max_acceleration_v.array() / sample.pddq.array()).sqrt().minCoeff(),
+            (max_jerk_v.array() / sample.pdddq.array()).pow(1.0 / 3).minCoeff(),
+        });
+
+        for (const auto& section: section_limits) {
+            if (std::floor(section.s_start / s_step) <= index && index <= std::ceil(section.s_end / s_step)) {
+                limits.velocity = std::min(limits.velocity, section.max_ds);
+                limits.acceleration = std::min(limits.acceleration, section.max_dds);
+                limits.jerk = std::min(limits.jerk, section.max_ddds);
+            }
+        }
+        return limits;
     }
 
-    //! Returns list of path positions s at delta time
-    Trajectory parametrize(const Path& path, const std::array<double, 7>& max_velocity, const std::array<double, 7>& max_acceleration, const std::array<double, 7>& max_jerk) {
-        Trajectory trajectory {path};
+    //! Returns the (duration, jerk) phases of the fastest jerk-limited braking to standstill. A path acceleration
+    //! beyond the braking limits is reduced with the ramp jerk first, e.g. when braking in a curve follows a straight part.
+    static std::array<std::tuple<double, double>, 4> stop_profile(double ds, double dds, double max_dds, double max_ddds, double ramp_ddds) {
+        std::tuple<double, double> ramp {0.0, 0.0};
+        if (dds < -max_dds) {
+            if (ds < (std::pow(dds, 2) - std::pow(max_dds, 2)) / (2 * ramp_ddds) + std::pow(max_dds, 2) / (2 * max_ddds)) { // Too slow to reach the braking limits
+                return {{{-dds / ramp_ddds, ramp_ddds}, {0.0, 0.0}, {0.0, 0.0}, {0.0, 0.0}}};
+            }
+            ramp = {(-max_dds - dds) / ramp_ddds, ramp_ddds};
 
-        // For linear segments: accelerate as fast as possible
-        // For blend segments: Constant path velocity ds
-        // Check continuous, and go back to zero velocity otherwise
+        } else if (dds > max_dds) {
+            ramp = {(dds - max_dds) / ramp_ddds, -ramp_ddds};
+        }
+        std::tie(std::ignore, ds, dds) = Profile::integrate(std::get<0>(ramp), 0.0, ds, dds, std::get<1>(ramp));
 
-        Vector7d max_velocity_v = Eigen::Map<const Vector7d>(max_velocity.data(), max_velocity.size());
-        Vector7d max_accleration_v = Eigen::Map<const Vector7d>(max_acceleration.data(), max_acceleration.size());
-        Vector7d max_jerk_v = Eigen::Map<const Vector7d>(max_jerk.data(), max_jerk.size());
+        double dds_peak = -std::sqrt(std::max((std::pow(dds, 2) + 2 * max_ddds * ds) / 2, 0.0));
+        if (dds < dds_peak) { // Already braking harder than necessary, release the acceleration immediately
+            return {{ramp, {0.0, 0.0}, {0.0, 0.0}, {-dds / max_ddds, max_ddds}}};
+        }
 
-        std::vector<std::tuple<double, double, double>> max_path_dynamics;
-        for (auto segment: path.segments) {
-            auto max_pddq = segment->max_pddq();
-            auto max_pdddq = segment->max_pdddq();
+        if (dds_peak >= -max_dds) {
+            return {{ramp, {(dds - dds_peak) / max_ddds, -max_ddds}, {0.0, 0.0}, {-dds_peak / max_ddds, max_ddds}}};
+        }
 
-            double max_ds, max_dds, max_ddds;
+        dds_peak = -max_dds;
+        const double t_peak = (dds - dds_peak) / max_ddds;
+        const double ds_peak = ds + t_peak * (dds + dds_peak) / 2;
+        const double t_constant = std::max((ds_peak - std::pow(max_dds, 2) / (2 * max_ddds)) / max_dds, 0.0);
+        return {{ramp, {t_peak, -max_ddds}, {t_constant, 0.0}, {max_dds / max_ddds, max_ddds}}};
+    }
+
+    //! Returns the end position and velocity of the stop profile
+    static std::tuple<double, double> stop_position(const std::array<std::tuple<double, double>, 4>& profile, double s, double ds, double dds) {
+        for (const auto& [t_phase, ddds]: profile) {
+            std::tie(s, ds, dds) = Profile::integrate(t_phase, s, ds, dds, ddds);
+        }
+        return {s, ds};
+    }
+
+    //! Whether a motion with constant jerk stays below the velocity curve, inconclusive parts are refined down to the sampling of the curve
+    template<class Curve>
+    static bool is_below_velocity_curve(const Curve& velocity, double t, double s, double ds, double dds, double ddds) {
+        const auto [s_end, ds_end, dds_end] = Profile::integrate(t, s, ds, dds, ddds);
+
+        double ds_max = std::max(ds, ds_end);
+        if (dds > 0.0 && dds_end < 0.0) {
+            ds_max = ds - std::pow(dds, 2) / (2 * ddds);
+        }
+        if (ds_max <= velocity.min(s, s_end)) {
+            return true;
+        }
+
+        if (s_end - s <= velocity.s_step) {
+            const double ds_limit = velocity.at(s), ds_end_limit = velocity.at(s_end);
+            return ds <= ds_limit && ds_end <= ds_end_limit && ds_max <= std::max(ds_limit, ds_end_limit);
+        }
+        const auto [s_mid, ds_mid, dds_mid] = Profile::integrate(t / 2, s, ds, dds, ddds);
+        return is_below_velocity_curve(velocity, t / 2, s, ds, dds, ddds) && is_below_velocity_curve(velocity, t / 2, s_mid, ds_mid, dds_mid, ddds);
+    }
 
-            // Linear segments
-            if ((max_pddq.array().abs() < 1e-16).any() && (max_pdddq.array().abs() < 1e-16).any()) {
-                auto constant_pdq = segment->pdq(0.0);
+    //! Returns the end of the window along s in which the path limits need to hold for braking from the given state
+    double stop_window_end(const PathLimits& limits, double s, double ds, double dds, double max_dds, double max_ddds, double ramp_ddds) const {
+        // The window includes the next time step, so that the generator is able to follow the braking
+        const double s_reachable = std::get<0>(Profile::integrate(delta_time, s, ds, dds, limits.jerk.min(s, s)));
+        return std::max(std::get<0>(stop_position(stop_profile(ds, dds, max_dds, max_ddds, ramp_ddds), s, ds, dds)), s_reachable);
+    }
 
-                max_ds = (max_velocity_v.array() / constant_pdq.array().abs()).minCoeff();
-                max_dds = (max_accleration_v.array() / constant_pdq.array().abs()).minCoeff();
-                max_ddds = (max_jerk_v.array() / constant_pdq.array().abs()).minCoeff();
+    /**
+     * Upper bound of the path velocity for a phase of braking with the given maximal path acceleration and jerk, so that
+     * the curvature and cross terms of the chain rule keep the joint-axis limits. Its minimum over an interval is
+     * calculated from the minima of the path limits, which is a lower bound of the actual minimum.
+     */
+    struct BrakingVelocity {
+        const PathLimits& limits;
+        double max_dds, max_ddds, s_step;
+
+        double bound(double velocity, double curvature, double cross, double acceleration, double jerk) const {
+            if (max_dds > acceleration || max_ddds > jerk) {
+                return -std::numeric_limits<double>::infinity();
+            }
 
-            // Other segments
+            // Solve (ds / curvature)^3 + ds max_dds / cross = jerk_share as x^3 + p x = q, in a numerically stable form
+            const double jerk_share = 1.0 - max_ddds / jerk;
+            double jerk_bound {std::numeric_limits<double>::infinity()};
+            if (std::isinf(curvature)) {
+                if (max_dds > 0.0) {
+                    jerk_bound = jerk_share * cross / max_dds;
+                }
             } else {
-                // ds = max_velocity_v.array() / pdq(s)  // pdq will always be between two linear segments...
-                double ds_acc = (max_accleration_v.array() / max_pddq.array().abs()).sqrt().minCoeff();
-                double ds_jerk = (max_jerk_v.array() / max_pdddq.array().abs()).pow(1./3).minCoeff();
-                max_ds = std::min(ds_acc, ds_jerk);
-                max_dds = 0.0;
-                max_ddds = 0.0;
+                const double p = std::pow(curvature, 3) * max_dds / cross, q = jerk_share * std::pow(curvature, 3);
+                const double w = std::cbrt(q / 2 + std::sqrt(std::pow(q, 2) / 4 + std::pow(p, 3) / 27));
+                jerk_bound = (w > 0.0) ? q / (std::pow(w, 2) + p / 3 + std::pow(p / (3 * w), 2)) : 0.0;
+            }
+            return std::min({velocity, curvature * std::sqrt(1.0 - max_dds / acceleration), jerk_bound});
+        }
+
+        double min(double s_min, double s_max) const {
+            const auto position = limits.velocity.min_position(s_min, s_max);
+            return bound(limits.velocity.min(position), limits.curvature.min(position), limits.cross.min(position), limits.acceleration.min(position), limits.jerk.min(position));
+        }
+
+        double at(double s) const {
+            return bound(limits.velocity.at(s), limits.curvature.at(s), limits.cross.at(s), limits.acceleration.at(s), limits.jerk.at(s));
+        }
+    };
+
+    //! Shares of the path acceleration and jerk limits for braking, from straight parts of the path to braking in curves
+    constexpr static std::array<double, 4> braking_shares {{1.0, 0.5, 0.25, 0.1}};
+
+    //! Returns the largest path acceleration and jerk limits for braking from the given state, as the given share of
+    //! their minimum over the braking window. A larger path acceleration is reduced with the jerk limit at s first.
+    std::optional<std::tuple<double, double, double>> stop_limits(const PathLimits& limits, double s, double ds, double dds, double s_stop, double share) const {
+        const double ramp_ddds = limits.jerk.min(s, s);
+        double max_dds = share * limits.acceleration.min(s, s);
+        double max_ddds = share * ramp_ddds;
+
+        // Slower braking reaches further and might include more restrictive parts of the path
+        for (size_t i = 0; i < 8; i += 1) {
+            const double s_end = std::min(stop_window_end(limits, s, ds, dds, max_dds, max_ddds, ramp_ddds), s_stop);
+            const double window_dds = share * limits.acceleration.min(s, s_end);
+            const double window_ddds = share * limits.jerk.min(s, s_end);
+            if (window_dds >= max_dds && window_ddds >= max_ddds) {
+                return std::make_tuple(max_dds, max_ddds, ramp_ddds);
+            }
+            max_dds = window_dds;
+            max_ddds = window_ddds;
+        }
+        return std::nullopt;
+    }
+
+    //! Returns the largest path acceleration and jerk limits for braking from the given state, for which the joint-axis
+    //! limits hold within the whole braking window at the peak path velocity of the braking
+    std::optional<std::tuple<double, double, double>> tight_stop_limits(const PathLimits& limits, double s, double ds, double dds, double s_stop) const {
+        const double ramp_ddds = limits.jerk.min(s, s);
+        double max_dds = limits.acceleration.min(s, s);
+        double max_ddds = ramp_ddds;
+
+        for (size_t i = 0; i < 8; i += 1) {
+            const double s_end = std::min(stop_window_end(limits, s, ds, dds, max_dds, max_ddds, ramp_ddds), s_stop);
+            const double ds_peak = (dds > 0.0) ? ds + std::pow(dds, 2) / (2 * std::min(max_ddds, ramp_ddds)) : ds;
+            const double ratio = ds_peak / limits.curvature.min(s, s_end);
+            if (ratio >= 1.0) {
+                return std::nullopt;
             }
 
-            max_path_dynamics.push_back({max_ds, max_dds, max_ddds});
+            // Share the remaining jerk equally between the cross term and the path jerk
+            const double jerk_share = 1.0 - std::pow(ratio, 3);
+            const double cross = limits.cross.min(s, s_end);
+            const double window_dds = std::min(limits.acceleration.min(s, s_end) * (1.0 - std::pow(ratio, 2)), (ds_peak > 0.0) ? jerk_share * cross / (2 * ds_peak) : std::numeric_limits<double>::infinity());
+            const double window_ddds = limits.jerk.min(s, s_end) * (jerk_share - ds_peak * window_dds / cross);
+            if (window_dds >= max_dds && window_ddds >= max_ddds) {
+                return std::make_tuple(max_dds, max_ddds, ramp_ddds);
+            }
+            max_dds = std::min(max_dds, window_dds);
+            max_ddds = std::min(max_ddds, window_ddds);
+        }
+        return std::nullopt;
+    }
+
+    //! Whether the generator can brake to standstill with the given limits from the given state before s_stop, while
+    //! keeping the velocity curve and the joint-axis limits of each braking phase
+    bool is_safe(const PathLimits& limits, double s, double ds, double dds, double s_stop, double max_dds, double max_ddds, double ramp_ddds) const {
+        const auto profile = stop_profile(ds, dds, max_dds, max_ddds, ramp_ddds);
+        const auto [s_end, ds_end] = stop_position(profile, s, ds, dds);
+        if (s_end > s_stop + 1e-12 || ds_end < -1e-12) {
+            return false;
         }
 
-        double current_s, current_ds, current_dds;
-        // Integrate forward and (if necessary) backward
-        // Get maximal possible velocity, acceleration
+        // Check the whole braking distance at once first
+        const double ds_peak = (dds > 0.0) ? ds + std::pow(dds, 2) / (2 * std::min(max_ddds, ramp_ddds)) : ds;
+        if (ds_peak <= BrakingVelocity {limits, std::max(std::abs(dds), max_dds), ramp_ddds, limits.velocity.s_step}.min(s, s_end)) {
+            return true;
+        }
 
-        // Calculate path at time steps
-        InputParameter<1> input;
-        OutputParameter<1> output;
-        Result otg_result {Result::Working};
+        for (const auto& [t_phase, ddds]: profile) {
+            if (t_phase > 0.0) {
+                const double dds_end = dds + ddds * t_phase;
+                const BrakingVelocity velocity {limits, std::max(std::abs(dds), std::abs(dds_end)), std::abs(ddds), limits.velocity.s_step};
+                if (!is_below_velocity_curve(velocity, t_phase, s, ds, dds, ddds)) {
+                    return false;
+                }
+            }
+            std::tie(s, ds, dds) = Profile::integrate(t_phase, s, ds, dds, ddds);
+        }
+        return true;
+    }
 
-        double time {0.0};
-        double s_new {0.0}, ds_new {0.0}, dds_new {0.0};
-        size_t index_current = path.get_index(s_new);
-        // auto [segment_new, s_local_new] = path.get_local(s_new);
+public:
+    class Stream;
 
-        Trajectory::State current_state {time, s_new, ds_new, dds_new, 0.0};
-        trajectory.states.push_back(current_state);
+    //! Maximal distance between two samples of the velocity curve along s
+    double s_resolution {1e-3};
 
-        input.current_position(0) = s_new;
-        input.current_velocity(0) = ds_new;
-        input.current_acceleration(0) = dds_new;
-        input.target_position(0) = path.get_length();
-        input.target_velocity(0) = 0.0;
-        std::tie(input.max_velocity(0), input.max_acceleration(0), input.max_jerk(0)) = max_path_dynamics[index_current];
+    //! Minimal distance along the path that a stream plans ahead of its current position
+    double lookahead {2.0};
 
-        while (otg_result == Result::Working) {
-            time += delta_time;
-            otg_result = otg->update(input, output);
+    //! Maximal Cartesian velocity of the path translation in [m/s]. For process applications, the path is traversed
+    //! with this constant tool speed and slows down only where the joint limits require it.
+    double max_tool_velocity {std::numeric_limits<double>::infinity()};
 
-            s_new = output.new_position(0);
-            ds_new = output.new_velocity(0);
-            dds_new = output.new_acceleration(0);
+    //! Additional limits of the path velocity, acceleration and jerk between s_start and s_end
+    struct SectionLimit {
+        double s_start, s_end, max_ds, max_dds;
+        double max_ddds {std::numeric_limits<double>::infinity()};
+    };
 
-            size_t index_new = path.get_index(s_new);
+    //! Sections of the path with additional limits, e.g. to slow down only where the joint limits would be exceeded by
+    //! a Cartesian path
+    std::vector<SectionLimit> section_limits;
 
-            // New segment
-            if (index_new > index_current) {
-                index_current = index_new;
+    explicit TimeParametrization(double delta_time): delta_time(delta_time) { }
+
+    //! Returns a stream that calculates the trajectory incrementally, keeping only the path limits within the lookahead in memory
+    Stream stream(const Path& path, const std::array<double, 7>& max_velocity, const std::array<double, 7>& max_acceleration, const std::array<double, 7>& max_jerk) const;
+
+    //! Returns list of path positions s at delta time
+    Trajectory parametrize(const Path& path, const std::array<double, 7>& max_velocity, const std::array<double, 7>& max_acceleration, const std::array<double, 7>& max_jerk);
+};
 
-                // std::tie(segment_new, s_local_new) = path.get_local(s_new);
-                // std::tie(input.max_velocity(0), input.max_acceleration(0), input.max_jerk(0)) = max_path_dynamics[index_current];
+
+/**
+ * Calculates the trajectory of a time parametrization one time step after the other. The path limits are sampled
+ * only within a window ahead of the current position, which is extended by the distance moved in each time step. New
+ * samples enter the window only after the velocity curve has been integrated backward from the lookahead beyond them.
+ * The end of the window is treated as a stop, so that the generator is always able to brake in time. Memory and
+ * calculation per time step are therefore independent of the path length.
+ */
+class TimeParametrization::Stream {
+    TimeParametrization parametrization;
+    Path path;
+
+    //! Minimal distance that is planned ahead of the current position
+    double lookahead;
+
+    //! Distance between the samples of the path limits, on a grid over the whole path
+    double s_step;
+
+    //! Path limits sampled within the current window
+    std::optional<PathLimits> limits;
+    double s_window_end {0.0};
+
+    //! Index of the last sample (at the path end), of the next sample to evaluate and of the next sample to bound
+    size_t last_index {0}, evaluate_index {0}, bound_index {0};
+
+    //! Segment of the next sample to evaluate, with its start position
+    size_t sample_segment {0};
+    double s_sample_segment {0.0};
+
+    //! Path derivatives of the samples from derivatives_index on, until both neighbors of a sample are evaluated
+    std::deque<SampleDerivatives> derivatives;
+    size_t derivatives_index {0};
+
+    //! Samples after the window, whose velocity curve might still be lowered by the backward integration
+    std::deque<LimitSample> pending;
+
+    //! The next position where the path velocity needs to be zero, and the segment (with its end position) to continue the search from
+    double s_stop {0.0}, s_segment_end {0.0};
+    size_t stop_segment {0};
+    bool is_last_stop {false};
+
+    //! Braking limits for which the current state is known to be safe
+    double stop_dds {0.0}, stop_ddds {0.0}, stop_ramp_ddds {0.0};
+    size_t stop_share_index {0};
+    double ddds_last {0.0};
+
+    //! Maximal number of jerks that are checked for safety within a time step, bounding its calculation time
+    constexpr static size_t max_jerk_evaluations {16};
+
+    Trajectory::State state {0.0, 0.0, 0.0, 0.0, 0.0};
+    bool finished {false};
+
+    //! Evaluates the path derivatives at the next sample, and bounds the limits of all samples with known neighbors
+    void evaluate_next_sample() {
+        const size_t index = evaluate_index;
+        const double s = std::min(index * s_step, path.get_length());
+        derivatives.emplace_back();
+
+        // The path derivatives might jump at the ends of segments in between two samples, so that these are added to both.
+        // Segments shorter than the sample distance are evaluated in their middle as well.
+        auto add_segment_point = [&](double s_local) {
+            const double position = (s_sample_segment + s_local) / s_step;
+            for (double neighbor: {std::floor(position), std::ceil(position)}) {
+                if (neighbor >= derivatives_index && neighbor <= index) {
+                    derivatives[size_t(neighbor) - derivatives_index].add(*path.segments[sample_segment], s_local);
+                }
+            }
+        };
+        auto add_segment_end = [&]() {
+            const double length = path.segments[sample_segment]->get_length();
+            if (length < 2 * s_step) {
+                add_segment_point(length / 2);
+            }
+            add_segment_point(length);
+        };
+
+        if (derivatives.size() == 1) {
+            add_segment_point(0.0);
+        }
+        while (sample_segment + 1 < path.segments.size() && s_sample_segment + path.segments[sample_segment]->get_length() <= s) {
+            add_segment_end();
+            s_sample_segment += path.segments[sample_segment]->get_length();
+            sample_segment += 1;
+            add_segment_point(0.0);
+        }
+        if (index == last_index) {
+            add_segment_end();
+        }
+
+        const auto& segment = *path.segments[sample_segment];
+        derivatives.back().add(segment, std::clamp(s - s_sample_segment, 0.0, segment.get_length()));
+        evaluate_index += 1;
+
+        // The derivatives of a sample are complete after the second next one is evaluated, as the middle of a short
+        // segment might lie before the previous sample
+        while (bound_index + 3 <= index || (index == last_index && bound_index <= last_index)) {
+            const auto& left = derivatives[std::max(bound_index, derivatives_index + 1) - 1 - derivatives_index];
+            const auto& right = derivatives[std::min(bound_index + 1, last_index) - derivatives_index];
+            add_pending(parametrization.bound_sample(bound_index, s_step, left, derivatives[bound_index - derivatives_index], right));
+            bound_index += 1;
+
+            if (derivatives_index + 1 < bound_index) {
+                derivatives.pop_front();
+                derivatives_index += 1;
+            }
+        }
+
+        // Samples enter the window once the velocity curve is integrated backward over the lookahead beyond them
+        while (pending.size() > std::max<size_t>(std::ceil(lookahead / s_step), 1)) {
+            move_pending_to_window();
+        }
+    }
+
+    //! Moves the oldest pending sample to the end of the window
+    void move_pending_to_window() {
+        const auto& sample = pending.front();
+        limits->velocity.push_back(sample.velocity);
+        limits->curvature.push_back(sample.curvature);
+        limits->cross.push_back(sample.cross);
+        limits->acceleration.push_back(sample.acceleration);
+        limits->jerk.push_back(sample.jerk);
+        pending.pop_front();
+
+        const size_t window_end = limits->velocity.index_end;
+        s_window_end = (window_end > last_index) ? path.get_length() : (window_end - 1) * s_step;
+    }
+
+    //! Integrates the velocity curve forward to a new sample, and backward from it with a jerk-limited path
+    //! acceleration, so that the generator does not need to brake abruptly in front of curves
+    void add_pending(LimitSample sample) {
+        if (!pending.empty()) {
+            sample.velocity = std::min(sample.velocity, std::sqrt(std::pow(pending.back().velocity, 2) + 2 * acceleration_between(pending.back(), sample) * s_step));
+        }
+        pending.push_back(sample);
+
+        // Each backward integration stops where it no longer lowers the velocity curve, as the integration from that
+        // sample is already included
+        double dds {0.0};
+        for (size_t i = pending.size() - 1; i > 0; i -= 1) {
+            const auto& next = pending[i];
+            auto& previous = pending[i - 1];
+            const double ds_step = std::max(next.velocity, 1e-6);
+            dds = std::min(dds + std::min(next.jerk, previous.jerk) * s_step / ds_step, acceleration_between(next, previous));
+            const double ds_brakeable = std::sqrt(std::pow(next.velocity, 2) + 2 * dds * s_step);
+            if (previous.velocity <= ds_brakeable) {
+                break;
+            }
+            previous.velocity = ds_brakeable;
+        }
+    }
+
+    //! Restarts the window of sampled path limits at the current position, e.g. after the path has changed
+    void reset_window() {
+        last_index = std::max<size_t>(std::ceil(path.get_length() / s_step - 1e-9), 1);
+        evaluate_index = bound_index = derivatives_index = std::min<size_t>(std::floor(state.s / s_step), last_index);
+        derivatives.clear();
+        pending.clear();
+
+        const double s_start = std::min(evaluate_index * s_step, path.get_length());
+        sample_segment = 0;
+        s_sample_segment = 0.0;
+        while (sample_segment + 1 < path.segments.size() && s_sample_segment + path.segments[sample_segment]->get_length() <= s_start) {
+            s_sample_segment += path.segments[sample_segment]->get_length();
+            sample_segment += 1;
+        }
+
+        // The window holds the samples from the current position up to the lookahead
+        const size_t capacity = std::ceil(lookahead / s_step) + 4;
+        limits.emplace(PathLimits {SampledCurve(s_step, bound_index, capacity), SampledCurve(s_step, bound_index, capacity), SampledCurve(s_step, bound_index, capacity), SampledCurve(s_step, bound_index, capacity), SampledCurve(s_step, bound_index, capacity)});
+        s_window_end = -std::numeric_limits<double>::infinity();
+        update_window();
+    }
+
+    //! Extends the window of sampled path limits up to the lookahead ahead of the current position. Per time step, this
+    //! evaluates only the samples for the distance moved since the last one. After the path end is evaluated, the
+    //! remaining samples enter the window in the same way.
+    void update_window() {
+        while (s_window_end < path.get_length() && s_window_end < state.s + lookahead) {
+            if (bound_index > last_index) {
+                move_pending_to_window();
+            } else {
+                evaluate_next_sample();
+            }
+        }
+    }
+
+    //! Searches the next position after the current stop where the path is not continuously differentiable, or the path end
+    void find_next_stop() {
+        while (stop_segment + 1 < path.segments.size()) {
+            const auto& left = path.segments[stop_segment];
+            const auto& right = path.segments[stop_segment + 1];
+            s_segment_end += left->get_length();
+            stop_segment += 1;
+
+            if ((left->pdq(left->get_length()) - right->pdq(0.0)).norm() > 1e-6) {
+                s_stop = s_segment_end;
+                return;
             }
+        }
+        s_stop = path.get_length();
+        is_last_stop = true;
+    }
+
+    //! Starts the motion towards the next stop from standstill
+    void start_section() {
+        find_next_stop();
+        update_window();
+
+        const double s_safe = std::min(s_stop, s_window_end);
+        std::tie(stop_dds, stop_ddds, stop_ramp_ddds) = parametrization.stop_limits(*limits, state.s, state.ds, state.dds, s_safe, braking_shares.back()).value_or(std::make_tuple(limits->acceleration.min(state.s, s_safe), limits->jerk.min(state.s, s_safe), limits->jerk.min(state.s, s_safe)));
+        ddds_last = 0.0;
+    }
+
+    //! Finishes the motion at the stop after the given time if the remaining braking is shorter than a time step. A
+    //! remaining braking is finished in the next time step, so that its jerk is not squeezed into the current one.
+    bool finish_at_stop(double delta_time = 0.0) {
+        const auto profile = stop_profile(state.ds, state.dds, stop_dds, stop_ddds, stop_ramp_ddds);
+        const double t_stop = std::get<0>(profile[0]) + std::get<0>(profile[1]) + std::get<0>(profile[2]) + std::get<0>(profile[3]);
+        if (t_stop >= parametrization.delta_time || s_stop - state.s >= 1e-6) {
+            return false;
+        }
+
+        state = {state.t + delta_time, s_stop, 0.0, 0.0, 0.0};
+        if (is_last_stop) {
+            finished = true;
+        } else {
+            start_section();
+        }
+        return true;
+    }
+
+public:
+    explicit Stream(const TimeParametrization& parametrization, const Path& path, double lookahead): parametrization(parametrization), path(path), lookahead(lookahead) {
+        const size_t steps = std::max<size_t>(std::ceil(path.get_length() / parametrization.s_resolution), 1);
+        s_step = (path.get_length() > 0.0) ? path.get_length() / steps : parametrization.s_resolution;
+
+        reset_window();
+        start_section();
+        while (!finished && finish_at_stop()) { }
+    }
+
+    //! The state of the current time step
+    const Trajectory::State& get_state() const {
+        return state;
+    }
+
+    //! Whether the end of the path is reached
+    bool is_finished() const {
+        return finished;
+    }
+
+    //! The path of the stream, including all appended waypoints
+    const Path& get_path() const {
+        return path;
+    }
+
+    //! Appends waypoints to the path, so that the motion continues instead of stopping at its former end. The path is
+    //! only changed beyond the braking distance of the current state, so that the generator stays within the limits.
+    void append(const std::vector<Waypoint>& waypoints, double blend_max_distance = 0.0) {
+        const double s_fixed = finished ? state.s : parametrization.stop_window_end(*limits, state.s, state.ds, state.dds, stop_dds, stop_ddds, stop_ramp_ddds);
+        path.append(waypoints, blend_max_distance, std::max(s_fixed, state.s));
+
+        // Resample the limits and search for the next stop again in the changed part of the path
+        reset_window();
+        if (finished) {
+            finished = false;
+            is_last_stop = false;
+            start_section();
+            while (!finished && finish_at_stop()) { }
+
+        } else if (is_last_stop) {
+            is_last_stop = false;
+            find_next_stop();
+        }
+    }
+
+    //! Calculates the state of the next time step
+    const Trajectory::State& step() {
+        if (finished) {
+            return state;
+        }
 
-            current_state = {time, s_new, ds_new, dds_new, 0.0};
-            trajectory.states.push_back(current_state);
+        // The braking of the last time step ends within this one
+        if (finish_at_stop(parametrization.delta_time)) {
+            while (!finished && finish_at_stop()) { }
+            return state;
+        }
 
-            input.current_position = output.new_position;
-            input.current_velocity = output.new_velocity;
-            input.current_acceleration = output.new_acceleration;
+        update_window();
+
+        const double delta_time = parametrization.delta_time;
+        const auto& path_limits = *limits;
+        const auto [time, s, ds, dds, ddds_current] = state;
+
+        // The end of the window acts as a stop, so that the generator can always brake before the path limits are unknown
+        const double s_safe = std::min(s_stop, s_window_end);
+
+        // The limits of this step hold up to the furthest reachable position, and depend on the path velocity and
+        // acceleration within the step
+        const double step_max_ddds = path_limits.jerk.min(s, s);
+        const double s_reachable = std::get<0>(Profile::integrate(delta_time, s, ds, dds, step_max_ddds));
+        const double step_curvature = path_limits.curvature.min(s, s_reachable);
+        const double step_ds = ds + std::max(dds, 0.0) * delta_time + step_max_ddds * std::pow(delta_time, 2) / 2;
+        const double step_abs_dds = std::abs(dds) + step_max_ddds * delta_time;
+        const double step_dds = max_acceleration_at(step_ds, step_curvature, path_limits.cross.min(s, s_reachable), path_limits.acceleration.min(s, s_reachable));
+        const double step_ddds = path_limits.jerk.min(s, s_reachable) * (1.0 - std::pow(step_ds / step_curvature, 3) - step_ds * step_abs_dds / path_limits.cross.min(s, s_reachable));
+
+        size_t step_share_index {stop_share_index}, evaluations {0};
+        auto safe_stop_limits = [&](double ddds) -> std::optional<std::tuple<double, double, double>> {
+            evaluations += 1;
+            if (!is_below_velocity_curve(path_limits.velocity, delta_time, s, ds, dds, ddds)) {
+                return std::nullopt;
+            }
+
+            const auto [s_new, ds_new, dds_new] = Profile::integrate(delta_time, s, ds, dds, ddds);
+
+            // Try the braking of the last time step first, as it usually stays the same. The index after the shares
+            // stands for the tight braking limits at the current path velocity.
+            for (size_t i = 0; i <= braking_shares.size() + 1; i += 1) {
+                const size_t share_index = (i == 0) ? stop_share_index : i - 1;
+                if (i > 0 && share_index == stop_share_index) {
+                    continue;
+                }
+
+                const auto window_limits = (share_index < braking_shares.size()) ? parametrization.stop_limits(path_limits, s_new, ds_new, dds_new, s_safe, braking_shares[share_index]) : parametrization.tight_stop_limits(path_limits, s_new, ds_new, dds_new, s_safe);
+                if (window_limits && parametrization.is_safe(path_limits, s_new, ds_new, dds_new, s_safe, std::get<0>(*window_limits), std::get<1>(*window_limits), std::get<2>(*window_limits))) {
+                    step_share_index = share_index;
+                    return window_limits;
+                }
+            }
+            if (parametrization.is_safe(path_limits, s_new, ds_new, dds_new, s_safe, stop_dds, stop_ddds, stop_ramp_ddds)) {
+                step_share_index = stop_share_index;
+                return std::make_tuple(stop_dds, stop_ddds, stop_ramp_ddds);
+            }
+            return std::nullopt;
+        };
+
+        // Jerk that continues the braking maneuver of the current state, matching its acceleration after the time step
+        double t_remaining {delta_time}, s_braking {s}, ds_braking {ds}, dds_braking {dds};
+        for (const auto& [t_phase, ddds_phase]: stop_profile(ds, dds, stop_dds, stop_ddds, stop_ramp_ddds)) {
+            const double t = std::min(t_phase, t_remaining);
+            std::tie(s_braking, ds_braking, dds_braking) = Profile::integrate(t, s_braking, ds_braking, dds_braking, ddds_phase);
+            t_remaining -= t;
         }
+        const double ddds_braking = std::clamp((dds_braking - dds) / delta_time, -stop_ramp_ddds, stop_ramp_ddds);
+
+        // Find the maximal safe jerk between braking and the path acceleration limits. The search keeps a safe jerk at
+        // all times, so that it only loses precision when it stops after the maximal number of evaluations.
+        double ddds_low = ddds_braking;
+        double ddds_high = std::max(std::min(step_ddds, (step_dds - dds) / delta_time), ddds_low);
+        const double ddds_precision = (ddds_high - ddds_low) / 4096;
+
+        double ddds = ddds_braking;
+        auto safe_limits = safe_stop_limits(ddds_high);
+        if (safe_limits) {
+            ddds = ddds_high;
+        } else {
+            // Search with growing steps from the jerk of the last time step, as it changes only slightly while the
+            // generator follows the velocity curve, and bisect the remaining interval afterwards
+            double ddds_step = ddds_precision;
+            const double ddds_start = std::clamp(ddds_last, ddds_low, ddds_high);
+            if ((safe_limits = safe_stop_limits(ddds_start))) {
+                ddds_low = ddds_start;
+                while (ddds_low + ddds_step < ddds_high && evaluations < max_jerk_evaluations) {
+                    if (const auto step_limits = safe_stop_limits(ddds_low + ddds_step)) {
+                        ddds_low += ddds_step;
+                        safe_limits = step_limits;
+                        ddds_step *= 2;
+                    } else {
+                        ddds_high = ddds_low + ddds_step;
+                        break;
+                    }
+                }
+            } else {
+                ddds_high = ddds_start;
+                while (ddds_high > ddds_low && evaluations < max_jerk_evaluations) {
+                    const double ddds_candidate = std::max(ddds_high - ddds_step, ddds_low);
+                    if ((safe_limits = safe_stop_limits(ddds_candidate))) {
+                        ddds_low = ddds_candidate;
+                        break;
+                    }
+                    ddds_high = ddds_candidate;
+                    ddds_step *= 2;
+                }
+            }
 
-        return trajectory;
+            if (safe_limits) {
+                while (ddds_high - ddds_low > ddds_precision && evaluations < max_jerk_evaluations) {
+                    const double ddds_mid = (ddds_low + ddds_high) / 2;
+                    if (const auto mid_limits = safe_stop_limits(ddds_mid)) {
+                        ddds_low = ddds_mid;
+                        safe_limits = mid_limits;
+                    } else {
+                        ddds_high = ddds_mid;
+                    }
+                }
+                ddds = ddds_low;
+            }
+        }
+        ddds_last = ddds;
+
+        if (safe_limits) {
+            std::tie(stop_dds, stop_ddds, stop_ramp_ddds) = *safe_limits;
+            stop_share_index = step_share_index;
+
+            const auto [s_new, ds_new, dds_new] = Profile::integrate(delta_time, s, ds, dds, ddds);
+            state = {time + delta_time, s_new, std::max(ds_new, 0.0), dds_new, ddds};
+        } else {
+            // Follow the braking maneuver exactly, as its jerk might change within the time step. A constant jerk
+            // would lag behind and overshoot the stop, which is snapped back afterwards.
+            state = {time + delta_time, s_braking, std::max(ds_braking, 0.0), dds_braking, ddds};
+        }
+        return state;
     }
 };
 
+
+inline TimeParametrization::Stream TimeParametrization::stream(const Path& path, const std::array<double, 7>& max_velocity, const std::array<double, 7>& max_acceleration, const std::array<double, 7>& max_jerk) const {
+    TimeParametrization parametrization {*this};
+    parametrization.max_velocity_v = Eigen::Map<const Vector7d>(max_velocity.data(), max_velocity.size());
+    parametrization.max_acceleration_v = Eigen::Map<const Vector7d>(max_acceleration.data(), max_acceleration.size());
+    parametrization.max_jerk_v = Eigen::Map<const Vector7d>(max_jerk.data(), max_jerk.size());
+    return Stream(parametrization, path, lookahead);
+}
+
+
+inline Trajectory TimeParametrization::parametrize(const Path& path, const std::array<double, 7>& max_velocity, const std::array<double, 7>& max_acceleration, const std::array<double, 7>& max_jerk) {
+    Trajectory trajectory {path};
+
+    // The whole trajectory is kept in memory anyway, so the path limits are sampled all at once
+    TimeParametrization parametrization {*this};
+    parametrization.lookahead = path.get_length();
+    auto stream = parametrization.stream(path, max_velocity, max_acceleration, max_jerk);
+
+    trajectory.states.push_back(stream.get_state());
+    while (!stream.is_finished()) {
+        trajectory.states.push_back(stream.step());
+    }
+    return trajectory;
+}
+
 } // namespace movex
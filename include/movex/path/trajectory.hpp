@@ -1,5 +1,9 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
 #include <movex/path/path.hpp>
 
 
@@ -20,6 +24,58 @@ struct Trajectory {
     std::vector<State> states;
 
     explicit Trajectory(const Path& path): path(path) { }
+
+    //! Returns the trajectory sampled with another time step (and the original final state), integrating the constant jerk of each original step
+    Trajectory resample(double delta_time) const {
+        if (delta_time <= 0.0) {
+            throw std::runtime_error("Trajectory can only be resampled with a positive time step.");
+        }
+
+        Trajectory result {path};
+        if (states.size() < 2) {
+            result.states = states;
+            return result;
+        }
+
+        const double t_start = states.front().t;
+        const double duration = states.back().t - t_start;
+        const size_t number_samples = static_cast<size_t>(std::floor(duration / delta_time + 1e-9)) + 1;
+        result.states.reserve(number_samples + 1);
+
+        size_t index {1};
+        for (size_t k = 0; k < number_samples; k += 1) {
+            const double t = t_start + k * delta_time;
+            while (index < states.size() && states[index].t < t) {
+                index += 1;
+            }
+            if (index >= states.size()) {
+                break;
+            }
+
+            // Keep the original states where the time steps coincide, as states at stops are snapped to standstill
+            const auto& previous = states[index - 1];
+            if (std::abs(states[index].t - t) < 1e-9 || std::abs(previous.t - t) < 1e-9) {
+                result.states.push_back(std::abs(states[index].t - t) < 1e-9 ? states[index] : previous);
+                continue;
+            }
+
+            // The jerk of a state was applied during the step leading to it
+            const double jerk = states[index].ddds;
+            const double dt = t - previous.t;
+            result.states.push_back({
+                t,
+                previous.s + dt * (previous.ds + dt * (previous.dds / 2 + dt * jerk / 6)),
+                previous.ds + dt * (previous.dds + dt * jerk / 2),
+                previous.dds + dt * jerk,
+                jerk,
+            });
+        }
+
+        if (result.states.back().t < states.back().t - 1e-9) {
+            result.states.push_back(states.back());
+        }
+        return result;
+    }
 };
 
 } // namespace movex
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <list>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+
+#include <movex/affine.hpp>
+#include <movex/waypoint.hpp>
+#include <movex/path/path.hpp>
+#include <movex/path/trajectory.hpp>
+
+
+namespace movex {
+
+/**
+ * Content-addressed cache of parametrized trajectories with least-recently-used eviction. A trajectory is found by
+ * the inputs of its planning (waypoints, interpolation, frame, limits and time step), and is only reused if the
+ * robot starts within a tolerance of the start pose of the cached trajectory.
+ */
+class TrajectoryCache {
+public:
+    //! Planning inputs of a trajectory, converted to a flat list of numbers and hashed for the lookup
+    struct Key {
+        std::vector<double> values;
+        uint64_t hash {14695981039346656037ull};
+
+        bool operator==(const Key& other) const {
+            return hash == other.hash && values == other.values;
+        }
+    };
+
+private:
+    struct Entry {
+        Key key;
+        Affine start;
+        std::shared_ptr<const Trajectory> trajectory;
+        size_t memory;
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return key.hash;
+        }
+    };
+
+    //! Entries ordered from the most to the least recently used
+    std::list<Entry> entries;
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+
+    size_t used_memory {0};
+
+    static void add(Key& key, double value) {
+        key.values.push_back(value);
+
+        // FNV-1a over the bytes of the value
+        std::array<unsigned char, sizeof(double)> bytes;
+        std::memcpy(bytes.data(), &value, sizeof(double));
+        for (const auto byte: bytes) {
+            key.hash = (key.hash ^ byte) * 1099511628211ull;
+        }
+    }
+
+    static void add(Key& key, const Affine& affine) {
+        for (const auto value: affine.array()) {
+            add(key, value);
+        }
+    }
+
+    static void add(Key& key, const std::array<double, 7>& array) {
+        for (const auto value: array) {
+            add(key, value);
+        }
+    }
+
+    static void add(Key& key, const std::optional<Vector7d>& vector) {
+        add(key, vector.has_value());
+        if (vector) {
+            for (size_t i = 0; i < 7; i += 1) {
+                add(key, (*vector)(i));
+            }
+        }
+    }
+
+    //! Approximate memory of a trajectory and its key in [bytes]
+    static size_t memory_of(const Key& key, const Trajectory& trajectory) {
+        return sizeof(Entry) + key.values.size() * sizeof(double) + trajectory.states.size() * sizeof(Trajectory::State) + trajectory.path.segments.size() * 16 * sizeof(Vector7d);
+    }
+
+    void evict(size_t memory) {
+        while (!entries.empty() && used_memory + memory > max_memory) {
+            used_memory -= entries.back().memory;
+            index.erase(entries.back().key);
+            entries.pop_back();
+        }
+    }
+
+public:
+    //! Maximal memory of all cached trajectories in [bytes]
+    size_t max_memory;
+
+    //! Maximal distance of the robot to the start of a cached trajectory for reuse in [m] and [rad]
+    double max_translation_difference {1e-4};
+    double max_rotation_difference {1e-3};
+
+    explicit TrajectoryCache(size_t max_memory = 64 * 1024 * 1024): max_memory(max_memory) { }
+
+    //! Returns the key of the trajectory planned from the given inputs, except of the start pose. Trajectories planned
+    //! in joint space (e.g. with checked joint limits) depend on the start joint positions q_start as well.
+    static Key get_key(const std::vector<Waypoint>& waypoints, Path::Interpolation interpolation, const Affine& frame, const std::array<double, 7>& max_velocity, const std::array<double, 7>& max_acceleration, const std::array<double, 7>& max_jerk, double delta_time, double max_tool_velocity = std::numeric_limits<double>::infinity(), bool check_joint_limits = false, bool optimize_elbow = false, const std::optional<Vector7d>& q_start = std::nullopt) {
+        Key key;
+        add(key, waypoints.size());
+        for (const auto& waypoint: waypoints) {
+            add(key, waypoint.affine);
+            add(key, waypoint.elbow.has_value());
+            add(key, waypoint.elbow.value_or(0.0));
+            add(key, static_cast<double>(waypoint.reference_type));
+            add(key, waypoint.blend_max_distance);
+        }
+        add(key, static_cast<double>(interpolation));
+        add(key, frame);
+        add(key, max_velocity);
+        add(key, max_acceleration);
+        add(key, max_jerk);
+        add(key, delta_time);
+        add(key, max_tool_velocity);
+        add(key, check_joint_limits);
+        add(key, optimize_elbow);
+        add(key, q_start);
+        return key;
+    }
+
+    //! Returns the cached trajectory for the key if it starts near the given pose, and marks it as recently used
+    std::shared_ptr<const Trajectory> find(const Key& key, const Affine& start) {
+        const auto found = index.find(key);
+        if (found == index.end()) {
+            return nullptr;
+        }
+
+        const auto& entry = *found->second;
+        const double translation_difference = (entry.start.translation() - start.translation()).norm();
+        const double rotation_difference = entry.start.quaternion().angularDistance(start.quaternion());
+        if (translation_difference > max_translation_difference || rotation_difference > max_rotation_difference) {
+            return nullptr;
+        }
+
+        entries.splice(entries.begin(), entries, found->second);
+        return entries.front().trajectory;
+    }
+
+    //! Adds a trajectory starting at the given pose, replacing a previous one with the same key
+    void insert(const Key& key, const Affine& start, const std::shared_ptr<const Trajectory>& trajectory) {
+        erase(key);
+
+        const size_t memory = memory_of(key, *trajectory);
+        if (memory > max_memory) {
+            return;
+        }
+
+        evict(memory);
+        entries.push_front({key, start, trajectory, memory});
+        index.emplace(key, entries.begin());
+        used_memory += memory;
+    }
+
+    void erase(const Key& key) {
+        const auto found = index.find(key);
+        if (found != index.end()) {
+            used_memory -= found->second->memory;
+            entries.erase(found->second);
+            index.erase(found);
+        }
+    }
+
+    void clear() {
+        entries.clear();
+        index.clear();
+        used_memory = 0;
+    }
+
+    //! Number of cached trajectories
+    size_t size() const {
+        return entries.size();
+    }
+
+    //! Approximate memory of all cached trajectories in [bytes]
+    size_t get_memory() const {
+        return used_memory;
+    }
+};
+
+} // namespace movex
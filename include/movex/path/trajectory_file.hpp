@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include <movex/file_mapping.hpp>
+#include <movex/path/path.hpp>
+#include <movex/path/trajectory.hpp>
+
+
+namespace movex {
+
+/**
+ * Versioned binary format of a parametrized trajectory. The file consists of a header, the path segments as
+ * (type, value count, values) records, and the trajectory states as a contiguous array of doubles. The states start
+ * at an aligned offset and are stored in the native layout of Trajectory::State, so that they can be used directly
+ * from a read-only memory mapping without parsing.
+ */
+struct TrajectoryFile {
+    constexpr static uint32_t version {1};
+
+    //! Alignment of the states within the file in [bytes]
+    constexpr static uint64_t states_alignment {64};
+
+    enum class SegmentType: uint64_t {
+        Line = 1,
+        QuarticBlend = 2,
+        Quintic = 3,
+        Slerp = 4,
+    };
+
+    struct Header {
+        std::array<char, 8> magic;
+        uint32_t version;
+
+        //! Written as 0x01020304 in the byte order of the writing machine
+        uint32_t byte_order;
+
+        //! Time step between the states in [s]
+        double delta_time;
+
+        uint64_t segment_count;
+        uint64_t state_count;
+
+        //! Position of the first state from the beginning of the file in [bytes]
+        uint64_t states_offset;
+    };
+
+    constexpr static std::array<char, 8> magic {{'M', 'O', 'V', 'E', 'X', 'T', 'R', 'J'}};
+    constexpr static uint32_t byte_order {0x01020304};
+
+    //! Writes the trajectory (with the time step of its parametrization) to the given file
+    static void write(const std::string& filename, const Trajectory& trajectory, double delta_time);
+};
+
+
+/**
+ * Trajectory loaded from a read-only memory mapping of a trajectory file. Only the (small) path is copied on
+ * construction, the states are read into (and if possible locked in) memory by the mapping.
+ */
+class MappedTrajectory {
+    FileMapping mapping;
+
+    //! Validates the header and returns the path from the segment records
+    static Path read_path(const FileMapping& mapping);
+
+    const Trajectory::State* states {nullptr};
+    size_t state_count {0};
+
+public:
+    //! The path of the trajectory, reconstructed from its segments
+    Path path;
+
+    //! Time step between the states in [s]
+    double delta_time;
+
+    explicit MappedTrajectory(const std::string& filename);
+
+    //! Number of states
+    size_t size() const {
+        return state_count;
+    }
+
+    const Trajectory::State& operator[](size_t index) const {
+        return states[index];
+    }
+
+    const Trajectory::State* begin() const {
+        return states;
+    }
+
+    const Trajectory::State* end() const {
+        return states + state_count;
+    }
+};
+
+} // namespace movex
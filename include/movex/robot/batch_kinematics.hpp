@@ -0,0 +1,148 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <movex/robot/kinematics.hpp>
+
+
+namespace movex {
+
+/**
+ * Forward and inverse kinematics for many configurations at once, e.g. for reachability analysis over large grids of
+ * poses. Configurations are stored as columns of a 7xN matrix and poses as columns of a 16xN matrix (the column-major
+ * 4x4 transformation, as the arrays of libfranka). The forward kinematics works on blocks of configurations in a
+ * structure-of-arrays layout, so that each arithmetic operation is vectorized over the block. The inverse kinematics
+ * branches per solution and is therefore calculated per pose. Both are split across threads.
+ */
+class BatchKinematics {
+public:
+    //! Number of configurations that are calculated together
+    constexpr static size_t block_size {8};
+
+private:
+    using Lane = Eigen::Array<double, block_size, 1>;
+
+    //! Upper 3x4 part of a transformation for a block of configurations, stored column by column
+    using BlockTransformation = std::array<std::array<Lane, 3>, 4>;
+
+    Kinematics kinematics;
+
+    //! Calls f(start, end) for consecutive ranges of whole blocks, distributed over the threads
+    template<class F>
+    void parallel_for(size_t n, F f) const {
+        const size_t blocks = (n + block_size - 1) / block_size;
+        const size_t threads = std::max<size_t>(std::min(number_threads, blocks), 1);
+        const size_t blocks_per_thread = (blocks + threads - 1) / threads;
+
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < threads; i += 1) {
+            workers.emplace_back([&, i]() {
+                f(std::min(i * blocks_per_thread * block_size, n), std::min((i + 1) * blocks_per_thread * block_size, n));
+            });
+        }
+        f(0, std::min(blocks_per_thread * block_size, n));
+
+        for (auto& worker: workers) {
+            worker.join();
+        }
+    }
+
+    void forward_block(const Eigen::Matrix<double, 7, block_size>& q, Eigen::Matrix<double, 16, block_size>& poses) const {
+        BlockTransformation m;
+        for (size_t column = 0; column < 4; column += 1) {
+            for (size_t row = 0; row < 3; row += 1) {
+                m[column][row].setConstant((row == column) ? 1.0 : 0.0);
+            }
+        }
+
+        for (size_t i = 0; i < 8; i += 1) {
+            const auto& [a, d, alpha] = Kinematics::dh_parameters[i];
+            const double ca = std::cos(alpha), sa = std::sin(alpha);
+
+            Lane ct, st;
+            if (i < 7) {
+                ct = q.row(i).transpose().array().cos();
+                st = q.row(i).transpose().array().sin();
+            } else {
+                ct.setOnes();
+                st.setZero();
+            }
+
+            // m * RotX(alpha) TransX(a) RotZ(theta) TransZ(d), see Kinematics::dh_transform
+            for (size_t row = 0; row < 3; row += 1) {
+                const Lane m0 = m[0][row], m1 = m[1][row], m2 = m[2][row];
+                const Lane m1_rotated = ca * m1 + sa * m2;
+                m[0][row] = ct * m0 + st * m1_rotated;
+                m[1][row] = ct * m1_rotated - st * m0;
+                m[2][row] = ca * m2 - sa * m1;
+                m[3][row] += a * m0 + d * m[2][row];
+            }
+        }
+
+        // End effector
+        const Eigen::Matrix4d F_T_EE = kinematics.F_T_EE.data.matrix();
+        for (size_t column = 0; column < 4; column += 1) {
+            for (size_t row = 0; row < 3; row += 1) {
+                Lane value = F_T_EE(0, column) * m[0][row] + F_T_EE(1, column) * m[1][row] + F_T_EE(2, column) * m[2][row];
+                if (column == 3) {
+                    value += m[3][row];
+                }
+                poses.row(4 * column + row) = value.transpose();
+            }
+            poses.row(4 * column + 3).setConstant((column == 3) ? 1.0 : 0.0);
+        }
+    }
+
+public:
+    //! Number of threads, including the calling one
+    size_t number_threads;
+
+    explicit BatchKinematics(const Kinematics& kinematics = Kinematics(), size_t number_threads = std::max(std::thread::hardware_concurrency(), 1u)): kinematics(kinematics), number_threads(number_threads) { }
+
+    //! Returns the poses of the end effector for each column of joint positions
+    Eigen::Matrix<double, 16, Eigen::Dynamic> forward(const Eigen::Matrix<double, 7, Eigen::Dynamic>& q) const {
+        Eigen::Matrix<double, 16, Eigen::Dynamic> poses(16, q.cols());
+
+        parallel_for(q.cols(), [&](size_t start, size_t end) {
+            Eigen::Matrix<double, 7, block_size> q_block;
+            Eigen::Matrix<double, 16, block_size> poses_block;
+            for (size_t i = start; i < end; i += block_size) {
+                // The last block is filled up with the last configuration
+                const size_t count = std::min(block_size, end - i);
+                q_block.leftCols(count) = q.middleCols(i, count);
+                q_block.rightCols(block_size - count).colwise() = q.col(i + count - 1);
+
+                forward_block(q_block, poses_block);
+                poses.middleCols(i, count) = poses_block.leftCols(count);
+            }
+        });
+        return poses;
+    }
+
+    //! Returns the joint positions within the limits that reach each pose with the given q7 and are closest to the
+    //! reference joint positions. Columns of unreachable poses are NaN.
+    Eigen::Matrix<double, 7, Eigen::Dynamic> inverse(const Eigen::Matrix<double, 16, Eigen::Dynamic>& poses, const Eigen::VectorXd& q7, const Eigen::Matrix<double, 7, Eigen::Dynamic>& q_reference) const {
+        if (q7.size() != poses.cols() || q_reference.cols() != poses.cols()) {
+            throw std::runtime_error("Batch inverse kinematics needs q7 and reference joint positions for each pose.");
+        }
+
+        Eigen::Matrix<double, 7, Eigen::Dynamic> q(7, poses.cols());
+        parallel_for(poses.cols(), [&](size_t start, size_t end) {
+            for (size_t i = start; i < end; i += 1) {
+                const Affine pose {Affine::Type(Eigen::Matrix4d::Map(poses.col(i).data()))};
+                const auto solution = kinematics.inverse(pose, q7(i), q_reference.col(i));
+                q.col(i) = solution ? *solution : Vector7d::Constant(std::numeric_limits<double>::quiet_NaN());
+            }
+        });
+        return q;
+    }
+};
+
+} // namespace movex
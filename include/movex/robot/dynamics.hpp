@@ -0,0 +1,231 @@
+#pragma once
+
+#include <array>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <movex/robot/kinematics.hpp>
+
+
+namespace movex {
+
+/**
+ * Rigid-body dynamics of the Franka Emika Panda with the recursive Newton-Euler algorithm for joint torques and the
+ * composite rigid-body algorithm for the mass matrix. The inertial parameters of the links are the identified ones of
+ * Gaz et al., "Dynamic Identification of the Franka Emika Panda Robot With Retrieval of Feasible Parameters Using
+ * Penalty-Based Optimization" (2019), without friction. Everything attached to the flange, e.g. the gripper and its
+ * payload, is set as load. All calculations use fixed-size matrices only, so that they can be called within the
+ * control loop.
+ */
+class Dynamics {
+    using Matrix6d = Eigen::Matrix<double, 6, 6>;
+    using Vector6d = Eigen::Matrix<double, 6, 1>;
+
+    //! Mass in [kg], center of mass in [m] and rotational inertia around the center of mass in [kg m^2], all in the frame of the link
+    struct Link {
+        double mass;
+        Eigen::Vector3d com;
+        Eigen::Matrix3d inertia;
+    };
+
+    //! Links including the load on the last one, and their spatial inertias
+    std::array<Link, 7> links;
+    std::array<Matrix6d, 7> spatial_inertias;
+
+    static Eigen::Matrix3d skew(const Eigen::Vector3d& v) {
+        Eigen::Matrix3d result;
+        result << 0.0, -v(2), v(1),
+                  v(2), 0.0, -v(0),
+                  -v(1), v(0), 0.0;
+        return result;
+    }
+
+    //! Transformation from the frame of the previous to the frame of the given link
+    static Eigen::Matrix4d link_transform(size_t i, double q) {
+        const auto& [a, d, alpha] = Kinematics::dh_parameters[i];
+        return Kinematics::dh_transform(a, d, alpha, q);
+    }
+
+    //! Spatial inertia with the angular part first, as in Featherstone's notation
+    static Matrix6d spatial_inertia(const Link& link) {
+        const Eigen::Matrix3d c = skew(link.com);
+
+        Matrix6d result;
+        result.topLeftCorner<3, 3>() = link.inertia + link.mass * c * c.transpose();
+        result.topRightCorner<3, 3>() = link.mass * c;
+        result.bottomLeftCorner<3, 3>() = link.mass * c.transpose();
+        result.bottomRightCorner<3, 3>() = link.mass * Eigen::Matrix3d::Identity();
+        return result;
+    }
+
+    //! Joint torques for the given motion and gravity with the recursive Newton-Euler algorithm
+    Vector7d rnea(const Vector7d& q, const Vector7d& dq, const Vector7d& ddq, const Eigen::Vector3d& gravity) const {
+        const Eigen::Vector3d z = Eigen::Vector3d::UnitZ();
+
+        std::array<Eigen::Matrix4d, 7> transforms;
+        std::array<Eigen::Vector3d, 7> forces, torques;
+
+        // Forward recursion of the velocities and accelerations, gravity as acceleration of the base
+        Eigen::Vector3d omega = Eigen::Vector3d::Zero(), domega = Eigen::Vector3d::Zero(), acceleration = -gravity;
+        for (size_t i = 0; i < 7; i += 1) {
+            transforms[i] = link_transform(i, q(i));
+            const Eigen::Matrix3d R_T = transforms[i].block<3, 3>(0, 0).transpose();
+            const Eigen::Vector3d p = transforms[i].block<3, 1>(0, 3);
+
+            acceleration = R_T * (acceleration + domega.cross(p) + omega.cross(omega.cross(p)));
+            domega = R_T * domega + (R_T * omega).cross(dq(i) * z) + ddq(i) * z;
+            omega = R_T * omega + dq(i) * z;
+
+            const auto& link = links[i];
+            const Eigen::Vector3d acceleration_com = acceleration + domega.cross(link.com) + omega.cross(omega.cross(link.com));
+            forces[i] = link.mass * acceleration_com;
+            torques[i] = link.inertia * domega + omega.cross(link.inertia * omega);
+        }
+
+        // Backward recursion of the forces and torques
+        Vector7d tau;
+        Eigen::Vector3d f = Eigen::Vector3d::Zero(), n = Eigen::Vector3d::Zero();
+        for (size_t i = 7; i-- > 0;) {
+            Eigen::Vector3d f_child = Eigen::Vector3d::Zero(), n_child = Eigen::Vector3d::Zero();
+            if (i < 6) {
+                const Eigen::Matrix3d R = transforms[i + 1].block<3, 3>(0, 0);
+                const Eigen::Vector3d p = transforms[i + 1].block<3, 1>(0, 3);
+                f_child = R * f;
+                n_child = R * n + p.cross(f_child);
+            }
+
+            n = torques[i] + n_child + links[i].com.cross(forces[i]);
+            f = forces[i] + f_child;
+            tau(i) = n(2);
+        }
+        return tau;
+    }
+
+    //! Updates the last link with the load and all spatial inertias
+    void update_links(double load_mass, const Eigen::Vector3d& F_x_Cload, const Eigen::Matrix3d& load_inertia) {
+        for (size_t i = 0; i < 7; i += 1) {
+            const auto& c = link_coms[i];
+            const auto& I = link_inertias[i];
+            links[i].mass = link_masses[i];
+            links[i].com << c[0], c[1], c[2];
+            links[i].inertia << I[0], I[1], I[2],
+                                I[1], I[3], I[4],
+                                I[2], I[4], I[5];
+        }
+
+        // Combine the load with the last link around their common center of mass
+        if (load_mass > 0.0) {
+            const Eigen::Matrix4d T_flange = link_transform(7, 0.0);
+            const Eigen::Matrix3d R_flange = T_flange.block<3, 3>(0, 0);
+            const Eigen::Vector3d load_com = T_flange.block<3, 1>(0, 3) + R_flange * F_x_Cload;
+
+            auto& link = links[6];
+            const double mass = link.mass + load_mass;
+            const Eigen::Vector3d com = (link.mass * link.com + load_mass * load_com) / mass;
+
+            // Parallel axis theorem
+            auto shifted = [&com](double m, const Eigen::Vector3d& c, const Eigen::Matrix3d& inertia) -> Eigen::Matrix3d {
+                const Eigen::Vector3d r = c - com;
+                return inertia + m * (r.squaredNorm() * Eigen::Matrix3d::Identity() - r * r.transpose());
+            };
+
+            link.inertia = shifted(link.mass, link.com, link.inertia) + shifted(load_mass, load_com, R_flange * load_inertia * R_flange.transpose());
+            link.mass = mass;
+            link.com = com;
+        }
+
+        for (size_t i = 0; i < 7; i += 1) {
+            spatial_inertias[i] = spatial_inertia(links[i]);
+        }
+    }
+
+public:
+    //! Identified masses in [kg], centers of mass in [m] and inertias around them in [kg m^2] (xx, xy, xz, yy, yz, zz) of
+    //! the seven links, all in the frame of the link
+    static constexpr std::array<double, 7> link_masses {{4.970684, 0.646926, 3.228604, 3.587895, 1.225946, 1.666555, 0.735522}};
+    static constexpr std::array<std::array<double, 3>, 7> link_coms {{
+        {{3.875e-03, 2.081e-03, -0.1750}},
+        {{-3.141e-03, -2.872e-02, 3.495e-03}},
+        {{2.7518e-02, 3.9252e-02, -6.6502e-02}},
+        {{-5.317e-02, 1.04419e-01, 2.7454e-02}},
+        {{-1.1953e-02, 4.1065e-02, -3.8437e-02}},
+        {{6.0149e-02, -1.4117e-02, -1.0517e-02}},
+        {{1.0517e-02, -4.252e-03, 6.1597e-02}},
+    }};
+    static constexpr std::array<std::array<double, 6>, 7> link_inertias {{
+        {{7.0337e-01, -1.39e-04, 6.772e-03, 7.0661e-01, 1.9169e-02, 9.117e-03}},
+        {{7.962e-03, -3.925e-03, 1.0254e-02, 2.811e-02, 7.04e-04, 2.5995e-02}},
+        {{3.7242e-02, -4.761e-03, -1.1396e-02, 3.6155e-02, -1.2805e-02, 1.083e-02}},
+        {{2.5853e-02, 7.796e-03, -1.332e-03, 1.9552e-02, 8.641e-03, 2.8323e-02}},
+        {{3.5549e-02, -2.117e-03, -4.037e-03, 2.9474e-02, 2.29e-04, 8.627e-03}},
+        {{1.964e-03, 1.09e-04, -1.158e-03, 4.354e-03, 3.41e-04, 5.433e-03}},
+        {{1.2516e-02, -4.28e-04, -1.196e-03, 1.0027e-02, -7.41e-04, 4.815e-03}},
+    }};
+
+    //! Gravity vector of the earth in the base frame in [m/s^2]
+    Eigen::Vector3d gravity_earth {0.0, 0.0, -9.81};
+
+    explicit Dynamics() {
+        update_links(0.0, Eigen::Vector3d::Zero(), Eigen::Matrix3d::Zero());
+    }
+
+    explicit Dynamics(double load_mass, const std::array<double, 3>& F_x_Cload, const std::array<double, 9>& load_inertia) {
+        set_load(load_mass, F_x_Cload, load_inertia);
+    }
+
+    //! Sets the load attached to the flange, as setLoad of libfranka: its mass in [kg], its center of mass in the flange
+    //! frame in [m], and its column-major inertia matrix around the center of mass in [kg m^2]
+    void set_load(double load_mass, const std::array<double, 3>& F_x_Cload, const std::array<double, 9>& load_inertia) {
+        update_links(load_mass, Eigen::Vector3d(F_x_Cload.data()), Eigen::Matrix3d(load_inertia.data()));
+    }
+
+    //! Returns the joint torques for the given joint positions, velocities and accelerations, including gravity
+    Vector7d inverse_dynamics(const Vector7d& q, const Vector7d& dq, const Vector7d& ddq) const {
+        return rnea(q, dq, ddq, gravity_earth);
+    }
+
+    //! Returns the Coriolis and centrifugal torques C(q, dq) dq
+    Vector7d coriolis(const Vector7d& q, const Vector7d& dq) const {
+        return rnea(q, dq, Vector7d::Zero(), Eigen::Vector3d::Zero());
+    }
+
+    //! Returns the gravity torques
+    Vector7d gravity(const Vector7d& q) const {
+        return rnea(q, Vector7d::Zero(), Vector7d::Zero(), gravity_earth);
+    }
+
+    //! Returns the symmetric mass matrix with the composite rigid-body algorithm
+    Eigen::Matrix<double, 7, 7> mass_matrix(const Vector7d& q) const {
+        // Spatial motion transformations from the frame of the previous link
+        std::array<Matrix6d, 7> X;
+        for (size_t i = 0; i < 7; i += 1) {
+            const Eigen::Matrix4d T = link_transform(i, q(i));
+            const Eigen::Matrix3d E = T.block<3, 3>(0, 0).transpose();
+
+            X[i].setZero();
+            X[i].topLeftCorner<3, 3>() = E;
+            X[i].bottomLeftCorner<3, 3>() = -E * skew(T.block<3, 1>(0, 3));
+            X[i].bottomRightCorner<3, 3>() = E;
+        }
+
+        std::array<Matrix6d, 7> composite = spatial_inertias;
+        for (size_t i = 6; i > 0; i -= 1) {
+            composite[i - 1] += X[i].transpose() * composite[i] * X[i];
+        }
+
+        // The motion subspace of each joint is the angular z-axis, so that its products select the third column or row
+        Eigen::Matrix<double, 7, 7> M;
+        for (size_t i = 0; i < 7; i += 1) {
+            Vector6d force = composite[i].col(2);
+            M(i, i) = force(2);
+            for (size_t j = i; j > 0; j -= 1) {
+                force = X[j].transpose() * force;
+                M(i, j - 1) = M(j - 1, i) = force(2);
+            }
+        }
+        return M;
+    }
+};
+
+} // namespace movex
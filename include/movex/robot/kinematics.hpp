@@ -0,0 +1,264 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <tuple>
+#include <vector>
+
+#include <Eigen/Geometry>
+
+#include <movex/affine.hpp>
+
+
+namespace movex {
+
+/**
+ * Analytic kinematics of the Franka Emika Panda, based on the modified Denavit-Hartenberg parameters of its official
+ * documentation. The elbow is the position of the third joint, as in the Cartesian poses of libfranka. All
+ * calculations use fixed-size matrices only, so that they can be called within the control loop.
+ */
+class Kinematics {
+    friend class Dynamics;
+
+    //! Transformation of a joint with modified DH parameters: RotX(alpha) TransX(a) RotZ(theta) TransZ(d)
+    static Eigen::Matrix4d dh_transform(double a, double d, double alpha, double theta) {
+        const double ct = std::cos(theta), st = std::sin(theta);
+        const double ca = std::cos(alpha), sa = std::sin(alpha);
+
+        Eigen::Matrix4d result;
+        result << ct, -st, 0.0, a,
+                  st * ca, ct * ca, -sa, -d * sa,
+                  st * sa, ct * sa, ca, d * ca,
+                  0.0, 0.0, 0.0, 1.0;
+        return result;
+    }
+
+    //! Rotations around the x- and z-axis
+    static Eigen::Matrix3d rot_x(double angle) {
+        return Eigen::AngleAxisd(angle, Eigen::Vector3d::UnitX()).toRotationMatrix();
+    }
+
+    static Eigen::Matrix3d rot_z(double angle) {
+        return Eigen::AngleAxisd(angle, Eigen::Vector3d::UnitZ()).toRotationMatrix();
+    }
+
+    //! Writes all solutions of the inverse kinematics for the flange pose and q7 into the array and returns their count.
+    //! For a singular shoulder (q2 = 0), q1 is taken from the given reference.
+    static size_t solve(const Eigen::Matrix4d& O_T_F, double q7, double q1_reference, std::array<Vector7d, 8>& solutions) {
+        constexpr double d1 {0.333}, d3 {0.316}, a4 {0.0825}, d5 {0.384}, a7 {0.088}, d_flange {0.107};
+
+        // Frame of the sixth joint from the flange and q7
+        Eigen::Matrix4d T7 = dh_transform(a7, 0.0, M_PI / 2, q7);
+        T7(2, 3) = 0.0;  // Without translation along z, as alpha leaves it unchanged
+        Eigen::Matrix4d O_T_7 = O_T_F;
+        O_T_7.block<3, 1>(0, 3) -= d_flange * O_T_F.block<3, 1>(0, 2);
+        const Eigen::Matrix4d O_T_6 = O_T_7 * T7.inverse();
+
+        const Eigen::Vector3d P2 {0.0, 0.0, d1};
+        const Eigen::Vector3d P6 = O_T_6.block<3, 1>(0, 3);
+        const Eigen::Matrix3d R6 = O_T_6.block<3, 3>(0, 0);
+
+        // q4 from the distance between shoulder and wrist: alpha c4 + beta s4 = k
+        const double alpha = 2 * (d5 * d3 - a4 * a4);
+        const double beta = -2 * a4 * (d5 + d3);
+        const double k = (P6 - P2).squaredNorm() - (2 * a4 * a4 + d5 * d5 + d3 * d3);
+        const double radius = std::hypot(alpha, beta);
+        if (std::abs(k) > radius) {
+            return 0;
+        }
+
+        size_t count {0};
+        const double phi = std::atan2(beta, alpha);
+        const double acos_k = std::acos(k / radius);
+        for (const double q4_candidate: {phi + acos_k, phi - acos_k}) {
+            const double q4 = std::remainder(q4_candidate, 2 * M_PI);
+            const double c4 = std::cos(q4), s4 = std::sin(q4);
+
+            // The shoulder in the frame of the sixth joint depends only on q4, q5 and q6
+            const double vx = a4 - a4 * c4 - d3 * s4;
+            const double vy = a4 * s4 - d3 * c4 - d5;
+            const Eigen::Vector3d p = R6.transpose() * (P2 - P6);
+            if (std::abs(vx) < 1e-12 || std::abs(p(2) / vx) > 1.0) {
+                continue;
+            }
+
+            const double asin_q5 = std::asin(p(2) / vx);
+            for (const double q5: {asin_q5, std::remainder(M_PI - asin_q5, 2 * M_PI)}) {
+                // The range of q6 exceeds pi, so that it is wrapped around its lower limit instead of zero
+                double q6 = std::remainder(std::atan2(vy, vx * std::cos(q5)) - std::atan2(p(1), p(0)), 2 * M_PI);
+                if (q6 < min_joint_position[5]) {
+                    q6 += 2 * M_PI;
+                }
+
+                // Remaining rotation of the first three joints: Rz(q1) Ry(q2) Rz(q3)
+                const Eigen::Matrix3d R4 = R6 * (rot_x(-M_PI / 2) * rot_z(q5) * rot_x(M_PI / 2) * rot_z(q6)).transpose();
+                const Eigen::Matrix3d R3 = R4 * (rot_x(M_PI / 2) * rot_z(q4)).transpose();
+
+                const double s2_abs = std::hypot(R3(0, 2), R3(1, 2));
+                if (s2_abs < 1e-9) {
+                    const double q1 = q1_reference;
+                    const double q3 = std::remainder(std::atan2(R3(1, 0), R3(0, 0)) - q1, 2 * M_PI);
+                    solutions[count++] << q1, 0.0, q3, q4, q5, q6, q7;
+                    continue;
+                }
+
+                for (const double s2: {s2_abs, -s2_abs}) {
+                    const double q1 = std::atan2(R3(1, 2) / s2, R3(0, 2) / s2);
+                    const double q2 = std::atan2(s2, R3(2, 2));
+                    const double q3 = std::atan2(R3(2, 1) / s2, -R3(2, 0) / s2);
+                    solutions[count++] << q1, q2, q3, q4, q5, q6, q7;
+                }
+            }
+        }
+        return count;
+    }
+
+public:
+    //! Modified DH parameters (a, d, alpha) of the seven joints and the flange in [m] and [rad]
+    static constexpr std::array<std::array<double, 3>, 8> dh_parameters {{
+        {{0.0, 0.333, 0.0}},
+        {{0.0, 0.0, -M_PI / 2}},
+        {{0.0, 0.316, M_PI / 2}},
+        {{0.0825, 0.0, M_PI / 2}},
+        {{-0.0825, 0.384, -M_PI / 2}},
+        {{0.0, 0.0, M_PI / 2}},
+        {{0.088, 0.0, M_PI / 2}},
+        {{0.0, 0.107, 0.0}},
+    }};
+
+    //! Joint position limits in [rad]
+    static constexpr std::array<double, 7> min_joint_position {{-2.8973, -1.7628, -2.8973, -3.0718, -2.8973, -0.0175, -2.8973}};
+    static constexpr std::array<double, 7> max_joint_position {{2.8973, 1.7628, 2.8973, -0.0698, 2.8973, 3.7525, 2.8973}};
+
+    //! Transformation from the flange to the end effector, as set by setEE in libfranka. Defaults to the Franka Hand.
+    Affine F_T_EE {0.0, 0.0, 0.1034, -M_PI / 4, 0.0, 0.0};
+
+    explicit Kinematics() { }
+    explicit Kinematics(const Affine& F_T_EE): F_T_EE(F_T_EE) { }
+
+    //! Returns the transformations of the seven joint frames and the flange relative to the base
+    static std::array<Eigen::Matrix4d, 8> joint_frames(const Vector7d& q) {
+        std::array<Eigen::Matrix4d, 8> frames;
+        Eigen::Matrix4d current = Eigen::Matrix4d::Identity();
+        for (size_t i = 0; i < 8; i += 1) {
+            const auto& [a, d, alpha] = dh_parameters[i];
+            current = current * dh_transform(a, d, alpha, (i < 7) ? q(i) : 0.0);
+            frames[i] = current;
+        }
+        return frames;
+    }
+
+    //! Returns the pose of the flange
+    static Affine flange(const Vector7d& q) {
+        Eigen::Matrix4d result = Eigen::Matrix4d::Identity();
+        for (size_t i = 0; i < 8; i += 1) {
+            const auto& [a, d, alpha] = dh_parameters[i];
+            result = result * dh_transform(a, d, alpha, (i < 7) ? q(i) : 0.0);
+        }
+        return Affine(Affine::Type(result));
+    }
+
+    //! Returns the pose of the end effector
+    Affine forward(const Vector7d& q) const {
+        return flange(q) * F_T_EE;
+    }
+
+    //! Returns the pose of the end effector together with the elbow
+    std::tuple<Affine, double> forward_with_elbow(const Vector7d& q) const {
+        return {forward(q), q(2)};
+    }
+
+    //! Returns the geometric Jacobian of the end effector in the base frame, as the zero Jacobian of libfranka. The
+    //! first three rows map to the translational and the last three rows to the angular velocity.
+    Eigen::Matrix<double, 6, 7> jacobian(const Vector7d& q) const {
+        const auto frames = joint_frames(q);
+        const Eigen::Vector3d position = (frames[7] * F_T_EE.data.matrix()).block<3, 1>(0, 3);
+
+        Eigen::Matrix<double, 6, 7> result;
+        for (size_t i = 0; i < 7; i += 1) {
+            const Eigen::Vector3d z = frames[i].block<3, 1>(0, 2);
+            result.block<3, 1>(0, i) = z.cross(position - frames[i].block<3, 1>(0, 3));
+            result.block<3, 1>(3, i) = z;
+        }
+        return result;
+    }
+
+    //! Returns the time derivative of the Jacobian for the joint velocities dq
+    Eigen::Matrix<double, 6, 7> jacobian_derivative(const Vector7d& q, const Vector7d& dq) const {
+        const auto frames = joint_frames(q);
+        const Eigen::Vector3d position = (frames[7] * F_T_EE.data.matrix()).block<3, 1>(0, 3);
+        const Eigen::Matrix<double, 6, 7> J = jacobian(q);
+        const Eigen::Vector3d velocity = J.topRows<3>() * dq;
+
+        // Angular and translational velocity of the joint frames, accumulated from the base
+        Eigen::Vector3d omega = Eigen::Vector3d::Zero(), joint_velocity = Eigen::Vector3d::Zero();
+
+        Eigen::Matrix<double, 6, 7> result;
+        for (size_t i = 0; i < 7; i += 1) {
+            const Eigen::Vector3d z = frames[i].block<3, 1>(0, 2);
+            const Eigen::Vector3d p = frames[i].block<3, 1>(0, 3);
+            if (i > 0) {
+                joint_velocity += omega.cross(p - frames[i - 1].block<3, 1>(0, 3));
+            }
+
+            const Eigen::Vector3d dz = omega.cross(z);
+            result.block<3, 1>(0, i) = dz.cross(position - p) + z.cross(velocity - joint_velocity);
+            result.block<3, 1>(3, i) = dz;
+            omega += dq(i) * z;
+        }
+        return result;
+    }
+
+    //! Returns the manipulability index sqrt(det(J J^T)) of Yoshikawa, which approaches zero close to singularities
+    static double manipulability(const Eigen::Matrix<double, 6, 7>& jacobian) {
+        return std::sqrt(std::max((jacobian * jacobian.transpose()).determinant(), 0.0));
+    }
+
+    //! Returns all joint positions within the limits that reach the end effector pose, with the position of the last
+    //! joint q7 as free parameter of the redundant robot. For a singular shoulder, q1 is set to zero.
+    std::vector<Vector7d> inverse(const Affine& pose, double q7) const {
+        std::array<Vector7d, 8> solutions;
+        const size_t count = solve((pose * F_T_EE.inverse()).data.matrix(), q7, 0.0, solutions);
+
+        std::vector<Vector7d> result;
+        for (size_t i = 0; i < count; i += 1) {
+            if (is_within_limits(solutions[i])) {
+                result.push_back(solutions[i]);
+            }
+        }
+        return result;
+    }
+
+    //! Returns the joint positions within the limits that reach the end effector pose and are closest to the current
+    //! ones, without any allocation. For a singular shoulder, q1 is kept.
+    std::optional<Vector7d> inverse(const Affine& pose, double q7, const Vector7d& q_current) const {
+        std::array<Vector7d, 8> solutions;
+        const size_t count = solve((pose * F_T_EE.inverse()).data.matrix(), q7, q_current(0), solutions);
+
+        std::optional<Vector7d> result;
+        double min_distance {std::numeric_limits<double>::infinity()};
+        for (size_t i = 0; i < count; i += 1) {
+            const double distance = (solutions[i] - q_current).squaredNorm();
+            if (distance < min_distance && is_within_limits(solutions[i])) {
+                result = solutions[i];
+                min_distance = distance;
+            }
+        }
+        return result;
+    }
+
+    //! Whether the joint positions are within the limits
+    static bool is_within_limits(const Vector7d& q) {
+        for (size_t i = 0; i < 7; i += 1) {
+            if (q(i) < min_joint_position[i] || q(i) > max_joint_position[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+} // namespace movex
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <movex/affine.hpp>
+#include <movex/file_mapping.hpp>
+#include <movex/robot/kinematics.hpp>
+
+
+namespace movex {
+
+/**
+ * Precomputed reachability and dexterity of end effector poses on a voxel grid. Each voxel of the end effector
+ * position is split into bins of the approach direction (the z-axis of the end effector), uniform in the cosine of
+ * its polar angle and in its azimuth, so that the polar bins cover equal areas of the sphere. The rotation around the
+ * approach direction is not binned, as the last joint turns the flange nearly freely. For each bin, the map stores
+ * the best manipulability of all sampled joint positions within the joint limits, quantized to a byte with zero as
+ * unreachable. As the map is sampled, it might miss rarely reached bins, and a bin is reachable if any pose within it
+ * is.
+ *
+ * The map is stored as a versioned binary file of a header and the bins, which are used directly from a read-only
+ * memory mapping. A query is a constant-time lookup.
+ */
+class ReachabilityMap {
+public:
+    constexpr static uint32_t version {1};
+
+    //! Alignment of the bins within the file in [bytes]
+    constexpr static uint64_t bins_alignment {64};
+
+    struct Header {
+        std::array<char, 8> magic;
+        uint32_t version;
+
+        //! Written as 0x01020304 in the byte order of the writing machine
+        uint32_t byte_order;
+
+        //! Transformation from the flange to the end effector of the map, column-major
+        std::array<double, 16> F_T_EE;
+
+        //! Lower corner of the grid and edge length of a voxel in [m]
+        std::array<double, 3> origin;
+        double resolution;
+
+        //! Number of voxels along x, y and z, and of direction bins within each voxel
+        std::array<uint64_t, 3> size;
+        uint64_t polar_bins, azimuth_bins;
+
+        //! Manipulability of the quantized value 255
+        double max_manipulability;
+
+        //! Position of the first bin from the beginning of the file in [bytes]
+        uint64_t bins_offset;
+    };
+
+    constexpr static std::array<char, 8> magic {{'M', 'O', 'V', 'E', 'X', 'R', 'C', 'H'}};
+    constexpr static uint32_t byte_order {0x01020304};
+
+private:
+    Header header {};
+
+    //! Bins of either a computed map or a mapped file
+    std::vector<uint8_t> computed_bins;
+    std::shared_ptr<const FileMapping> mapping;
+
+    explicit ReachabilityMap() { }
+
+    const uint8_t* bins() const {
+        return mapping ? reinterpret_cast<const uint8_t*>(mapping->data + header.bins_offset) : computed_bins.data();
+    }
+
+    //! Returns the index of the bin of the pose, or the number of bins if the pose is outside the grid
+    size_t index(const Affine& pose) const {
+        size_t voxel {0};
+        for (size_t i = 0; i < 3; i += 1) {
+            const double position = std::floor((pose.data.translation()(i) - header.origin[i]) / header.resolution);
+            if (!(position >= 0.0 && position < header.size[i])) {
+                return bin_count();
+            }
+            voxel = voxel * header.size[i] + static_cast<size_t>(position);
+        }
+
+        // The linear part of the pose is a rotation already, so that it is not orthogonalized again
+        const Eigen::Vector3d approach = pose.data.linear().col(2);
+        const double azimuth = std::atan2(approach.y(), approach.x()) + M_PI;
+        const size_t polar_index = std::min<size_t>(std::max((1.0 - approach.z()) / 2, 0.0) * header.polar_bins, header.polar_bins - 1);
+        const size_t azimuth_index = std::min<size_t>(azimuth / (2 * M_PI) * header.azimuth_bins, header.azimuth_bins - 1);
+        return (voxel * header.polar_bins + polar_index) * header.azimuth_bins + azimuth_index;
+    }
+
+public:
+    //! Samples the given number of random joint positions within the limits and records the best manipulability of each bin.
+    //! The grid covers the whole workspace of the robot with the end effector.
+    static ReachabilityMap compute(const Kinematics& kinematics, double resolution = 0.05, size_t polar_bins = 8, size_t azimuth_bins = 16, size_t samples = 10000000, uint64_t seed = 42, size_t number_threads = std::max(std::thread::hardware_concurrency(), 1u));
+
+    //! Loads the map from a read-only memory mapping of a file
+    explicit ReachabilityMap(const std::string& filename);
+
+    //! Writes the map to the given file
+    void write(const std::string& filename) const;
+
+    //! Transformation from the flange to the end effector the map was computed for
+    Affine F_T_EE() const {
+        return Affine(header.F_T_EE);
+    }
+
+    double resolution() const {
+        return header.resolution;
+    }
+
+    //! Total number of bins
+    size_t bin_count() const {
+        return header.size[0] * header.size[1] * header.size[2] * header.polar_bins * header.azimuth_bins;
+    }
+
+    //! Returns the best sampled manipulability within the bin of the pose, or zero if the bin was not reached
+    double manipulability(const Affine& pose) const {
+        const size_t i = index(pose);
+        return (i < bin_count()) ? bins()[i] * header.max_manipulability / 255 : 0.0;
+    }
+
+    //! Returns the manipulability for each column-major pose of a 16xN matrix, as for BatchKinematics
+    Eigen::VectorXd manipulability(const Eigen::Matrix<double, 16, Eigen::Dynamic>& poses) const {
+        Eigen::VectorXd result(poses.cols());
+        for (Eigen::Index i = 0; i < poses.cols(); i += 1) {
+            result(i) = manipulability(Affine(Affine::Type(Eigen::Matrix4d::Map(poses.col(i).data()))));
+        }
+        return result;
+    }
+
+    //! Whether the bin of the pose was reached with at least the given manipulability
+    bool is_reachable(const Affine& pose, double min_manipulability = 0.0) const {
+        const size_t i = index(pose);
+        if (i >= bin_count()) {
+            return false;
+        }
+        const uint8_t value = bins()[i];
+        return value > 0 && value * header.max_manipulability / 255 >= min_manipulability;
+    }
+};
+
+} // namespace movex
@@ -126,10 +126,45 @@ PYBIND11_MODULE(_frankx, m) {
         .def(py::init<const std::array<double, 7>&>(), "target"_a)
         .def_readonly("target", &JointMotion::target);
 
+    py::class_<JointPathMotion>(m, "JointPathMotion")
+        .def(py::init<const std::vector<std::array<double, 7>>&, double>(), "waypoints"_a, "blend_max_distance"_a = 0.0)
+        .def_readonly("waypoints", &JointPathMotion::waypoints)
+        .def_readwrite("blend_max_distance", &JointPathMotion::blend_max_distance);
+
+    py::enum_<Path::Interpolation>(m, "PathInterpolation")
+        .value("Linear", Path::Interpolation::Linear)
+        .value("QuinticSpline", Path::Interpolation::QuinticSpline)
+        .value("Slerp", Path::Interpolation::Slerp)
+        .export_values();
+
+    py::class_<MappedTrajectory, std::shared_ptr<MappedTrajectory>>(m, "MappedTrajectory")
+        .def(py::init<const std::string&>(), "filename"_a)
+        .def_readonly("delta_time", &MappedTrajectory::delta_time)
+        .def("__len__", &MappedTrajectory::size);
+
+    py::class_<TrajectoryCache, std::shared_ptr<TrajectoryCache>>(m, "TrajectoryCache")
+        .def(py::init<size_t>(), "max_memory"_a = 64 * 1024 * 1024)
+        .def_readwrite("max_memory", &TrajectoryCache::max_memory)
+        .def_readwrite("max_translation_difference", &TrajectoryCache::max_translation_difference)
+        .def_readwrite("max_rotation_difference", &TrajectoryCache::max_rotation_difference)
+        .def("clear", &TrajectoryCache::clear)
+        .def("__len__", &TrajectoryCache::size)
+        .def_property_readonly("memory", &TrajectoryCache::get_memory);
+
     py::class_<PathMotion>(m, "PathMotion")
         .def(py::init<const std::vector<Waypoint>&>(), "waypoints"_a)
+        .def(py::init<const std::vector<Waypoint>&, Path::Interpolation>(), "waypoints"_a, "interpolation"_a)
         .def(py::init<const std::vector<Affine>&, double>(), "waypoints"_a, "blend_max_distance"_a = 0.0)
-        .def_readonly("waypoints", &PathMotion::waypoints);
+        .def(py::init([](const std::shared_ptr<MappedTrajectory>& trajectory) {
+            return PathMotion(trajectory);
+        }), "trajectory"_a)
+        .def_readonly("waypoints", &PathMotion::waypoints)
+        .def_readwrite("interpolation", &PathMotion::interpolation)
+        .def_readwrite("max_tool_velocity", &PathMotion::max_tool_velocity)
+        .def_readwrite("check_joint_limits", &PathMotion::check_joint_limits)
+        .def_readwrite("stream_joint_positions", &PathMotion::stream_joint_positions)
+        .def_readwrite("optimize_elbow", &PathMotion::optimize_elbow)
+        .def("append", &PathMotion::append, "waypoints"_a, "blend_max_distance"_a = 0.0);
 
     // py::class_<LinearMotion, PathMotion>(m, "LinearMotion")
     //     .def(py::init<const Affine&>(), "target"_a)
@@ -169,6 +204,8 @@ PYBIND11_MODULE(_frankx, m) {
         .def(py::init<double, double>(), "translational_stiffness"_a, "rotational_stiffness"_a)
         .def_property_readonly("is_active", &ImpedanceMotion::isActive)
         .def_property("target", &ImpedanceMotion::getTarget, &ImpedanceMotion::setTarget)
+        .def_readwrite("analytic_jacobian", &ImpedanceMotion::analytic_jacobian)
+        .def_readwrite("identified_dynamics", &ImpedanceMotion::identified_dynamics)
         .def("set_linear_relative_target_motion", &ImpedanceMotion::setLinearRelativeTargetMotion, "relative_target"_a, "duration"_a)
         .def("set_spiral_target_motion", &ImpedanceMotion::setSpiralTargetMotion)
         .def("add_force_constraint", (void (ImpedanceMotion::*)(std::optional<double>, std::optional<double>, std::optional<double>)) &ImpedanceMotion::addForceConstraint, py::kw_only(), "x"_a = std::nullopt, "y"_a = std::nullopt, "z"_a = std::nullopt)
@@ -321,6 +358,7 @@ PYBIND11_MODULE(_frankx, m) {
         .def_readwrite("jerk_rel", &Robot::jerk_rel)
         .def_readwrite("repeat_on_error", &Robot::repeat_on_error)
         .def_readwrite("stop_at_python_signal", &Robot::stop_at_python_signal)
+        .def_readwrite("trajectory_cache", &Robot::trajectory_cache)
         .def("server_version", &Robot::serverVersion)
         .def("set_default_behavior", &Robot::setDefaultBehavior)
         .def("set_cartesian_impedance", &Robot::setCartesianImpedance)
@@ -334,6 +372,8 @@ PYBIND11_MODULE(_frankx, m) {
         .def("recover_from_errors", &Robot::recoverFromErrors)
         .def("read_once", &Robot::readOnce)
         .def("current_pose", &Robot::currentPose, "frame"_a = Affine())
+        .def_static("forward_kinematics", &Robot::forwardKinematics, "q"_a)
+        .def("inverse_kinematics", &Robot::inverseKinematics, "target"_a, "frame"_a = Affine())
         // .def("forward_kinematics", &Robot::forwardKinematics, "q"_a)
         // .def("inverse_kinematics", &Robot::inverseKinematics, "target"_a, "frame"_a = Affine())
         .def("move", (bool (Robot::*)(ImpedanceMotion&)) &Robot::move, py::call_guard<py::gil_scoped_release>())
@@ -342,6 +382,8 @@ PYBIND11_MODULE(_frankx, m) {
         .def("move", (bool (Robot::*)(const Affine&, ImpedanceMotion&, MotionData&)) &Robot::move, py::call_guard<py::gil_scoped_release>())
         .def("move", (bool (Robot::*)(JointMotion)) &Robot::move, py::call_guard<py::gil_scoped_release>())
         .def("move", (bool (Robot::*)(JointMotion, MotionData&)) &Robot::move, py::call_guard<py::gil_scoped_release>())
+        .def("move", (bool (Robot::*)(JointPathMotion)) &Robot::move, py::call_guard<py::gil_scoped_release>())
+        .def("move", (bool (Robot::*)(JointPathMotion, MotionData&)) &Robot::move, py::call_guard<py::gil_scoped_release>())
         .def("move", (bool (Robot::*)(PathMotion)) &Robot::move, py::call_guard<py::gil_scoped_release>())
         .def("move", (bool (Robot::*)(PathMotion, MotionData&)) &Robot::move, py::call_guard<py::gil_scoped_release>())
         .def("move", (bool (Robot::*)(const Affine&, PathMotion)) &Robot::move, py::call_guard<py::gil_scoped_release>())
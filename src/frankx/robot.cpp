@@ -50,35 +50,34 @@ Affine Robot::currentPose(const Affine& frame) {
     return Affine(state.O_T_EE) * frame;
 }
 
-// Affine Robot::forwardKinematics(const std::array<double, 7>& q) {
-//     Affine result;
-
-//     control([&](const franka::RobotState& robot_state, franka::Duration period) -> franka::Torques {
-//         franka::CartesianPose cartesian_target(robot_state.O_T_EE_c, robot_state.elbow_c);
-//         result = Affine(cartesian_target.O_T_EE);
-//         return franka::MotionFinished(franka::Torques({0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0}));
-
-//     }, [&](const franka::RobotState& robot_state, franka::Duration period) -> franka::JointPositions {
+Affine Robot::forwardKinematics(const std::array<double, 7>& q) {
+    return Kinematics().forward(Vector7d(q.data()));
+}
 
-//         return franka::JointPositions(q);
-//     });
+std::optional<std::array<double, 7>> Robot::inverseKinematics(const Affine& target, const Affine& frame) {
+    auto state = readOnce();
+    const Vector7d q_current {state.q.data()};
 
-//     return result;
-// }
+    const auto q = Kinematics(Affine(state.F_T_EE)).inverse(target * frame.inverse(), q_current(6), q_current);
+    if (!q) {
+        return std::nullopt;
+    }
 
-// std::array<double, 7> Robot::inverseKinematics(const Affine& target, const Affine& frame) {
-//     std::array<double, 7> result;
-//     return result;
-// }
+    std::array<double, 7> result;
+    Eigen::VectorXd::Map(result.data(), 7) = *q;
+    return result;
+}
 
-std::tuple<std::array<double, 7>, std::array<double, 7>, std::array<double, 7>> Robot::getInputLimits(const MotionData& data) {
-    return getInputLimits(Waypoint(), data);
+std::tuple<std::array<double, 7>, std::array<double, 7>, std::array<double, 7>> Robot::getInputLimits(const MotionData& data, bool commands_joint_positions) {
+    return getInputLimits(Waypoint(), data, commands_joint_positions);
 }
 
-std::tuple<std::array<double, 7>, std::array<double, 7>, std::array<double, 7>> Robot::getInputLimits(const Waypoint& waypoint, const MotionData& data) {
-    constexpr double translation_factor {0.5};
-    constexpr double elbow_factor {0.32};
-    constexpr double derivative_factor {0.4};
+std::tuple<std::array<double, 7>, std::array<double, 7>, std::array<double, 7>> Robot::getInputLimits(const Waypoint& waypoint, const MotionData& data, bool commands_joint_positions) {
+    // Conservative factors keep Cartesian pose commands within the joint limits, while joint position commands are
+    // checked against the joint limits themselves
+    const double translation_factor = commands_joint_positions ? 1.0 : 0.5;
+    const double elbow_factor = commands_joint_positions ? 1.0 : 0.32;
+    const double derivative_factor = commands_joint_positions ? 1.0 : 0.4;
 
     if (waypoint.max_dynamics || data.max_dynamics) {
         auto max_velocity = VectorCartRotElbow(
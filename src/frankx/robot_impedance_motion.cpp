@@ -31,6 +31,8 @@ bool Robot::move(const Affine& frame, ImpedanceMotion& motion, MotionData& data)
 
     franka::Model model = loadModel();
     franka::RobotState initial_state = readOnce();
+    const Kinematics kinematics {Affine(initial_state.F_T_EE)};
+    const Dynamics dynamics {initial_state.m_total, initial_state.F_x_Ctotal, initial_state.I_total};
 
     Affine initial_affine = Affine(initial_state.O_T_EE);
     Eigen::Vector3d position_d(initial_affine.translation());
@@ -40,13 +42,25 @@ bool Robot::move(const Affine& frame, ImpedanceMotion& motion, MotionData& data)
     auto impedance_callback = [&](const franka::RobotState& robot_state, franka::Duration period) -> franka::Torques {
         time += period.toSec();
 
-        std::array<double, 7> coriolis_array = model.coriolis(robot_state);
-        std::array<double, 42> jacobian_array = model.zeroJacobian(franka::Frame::kEndEffector, robot_state);
-
-        Eigen::Map<const Eigen::Matrix<double, 7, 1>> coriolis(coriolis_array.data());
-        Eigen::Map<const Eigen::Matrix<double, 6, 7>> jacobian(jacobian_array.data());
         Eigen::Map<const Eigen::Matrix<double, 7, 1>> q(robot_state.q.data());
         Eigen::Map<const Eigen::Matrix<double, 7, 1>> dq(robot_state.dq.data());
+
+        Eigen::Matrix<double, 7, 1> coriolis;
+        if (motion.identified_dynamics) {
+            coriolis = dynamics.coriolis(q, dq);
+        } else {
+            const std::array<double, 7> coriolis_array = model.coriolis(robot_state);
+            coriolis = Eigen::Map<const Eigen::Matrix<double, 7, 1>>(coriolis_array.data());
+        }
+
+        Eigen::Matrix<double, 6, 7> jacobian;
+        if (motion.analytic_jacobian) {
+            jacobian = kinematics.jacobian(q);
+        } else {
+            const std::array<double, 42> jacobian_array = model.zeroJacobian(franka::Frame::kEndEffector, robot_state);
+            jacobian = Eigen::Map<const Eigen::Matrix<double, 6, 7>>(jacobian_array.data());
+        }
+
         Eigen::Affine3d transform(Eigen::Matrix4d::Map(robot_state.O_T_EE.data()));
         Eigen::Vector3d position(transform.translation());
         Eigen::Quaterniond orientation(transform.linear());
@@ -1,4 +1,5 @@
 #include <frankx/robot.hpp>
+#include <movex/path/time_parametrization.hpp>
 
 
 namespace frankx {
@@ -82,4 +83,63 @@ bool Robot::move(const Affine& frame, JointMotion motion, MotionData& data) {
     return true;
 }
 
+bool Robot::move(JointPathMotion motion) {
+    auto data = MotionData();
+    return move(motion, data);
+}
+
+bool Robot::move(JointPathMotion motion, MotionData& data) {
+    // Insert current joint positions into beginning of path
+    auto initial_state = readOnce();
+
+    std::vector<Vector7d> waypoints {Vector7d(initial_state.q_d.data())};
+    for (const auto& waypoint: motion.waypoints) {
+        waypoints.emplace_back(waypoint.data());
+    }
+    const Path path(waypoints, motion.blend_max_distance);
+
+    std::array<double, 7> max_velocity, max_acceleration, max_jerk;
+    for (size_t i = 0; i < degrees_of_freedoms; i += 1) {
+        max_velocity[i] = velocity_rel * data.velocity_rel * max_joint_velocity[i];
+        max_acceleration[i] = acceleration_rel * data.acceleration_rel * max_joint_acceleration[i];
+        max_jerk[i] = jerk_rel * data.jerk_rel * max_joint_jerk[i];
+    }
+
+    TimeParametrization time_parametrization {control_rate};
+    auto stream = time_parametrization.stream(path, max_velocity, max_acceleration, max_jerk);
+
+    std::array<double, 7> joint_positions;
+    auto target_positions = [&](double s) {
+        Eigen::VectorXd::Map(&joint_positions[0], 7) = path.q(s);
+        return franka::JointPositions(joint_positions);
+    };
+
+    auto motion_generator = [&](const franka::RobotState& robot_state, franka::Duration period) -> franka::JointPositions {
+#ifdef WITH_PYTHON
+        if (stop_at_python_signal && Py_IsInitialized() && PyErr_CheckSignals() == -1) {
+            stop();
+        }
+#endif
+
+        const int steps = std::max<int>(period.toMSec(), 1);
+        for (int i = 0; i < steps && !stream.is_finished(); i += 1) {
+            stream.step();
+        }
+
+        if (stream.is_finished()) {
+            return franka::MotionFinished(target_positions(path.get_length()));
+        }
+        return target_positions(stream.get_state().s);
+    };
+
+    try {
+        control(motion_generator);
+
+    } catch (franka::Exception exception) {
+        std::cout << exception.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
 } // namepace frankx
@@ -1,5 +1,9 @@
 #include <frankx/robot.hpp>
+#include <movex/path/elbow_optimizer.hpp>
+#include <movex/path/joint_limit_check.hpp>
+#include <movex/path/joint_trajectory_conversion.hpp>
 #include <movex/path/time_parametrization.hpp>
+#include <movex/path/trajectory_cache.hpp>
 
 
 namespace frankx {
@@ -23,22 +27,137 @@ bool Robot::move(const Affine& frame, PathMotion motion, MotionData& data) {
     franka::CartesianPose initial_cartesian_pose(initial_state.O_T_EE_c, initial_state.elbow_c);
     Affine initial_pose(initial_cartesian_pose.O_T_EE);
 
+    const auto& trajectory = motion.trajectory;
+    if (trajectory) {
+        // A precomputed trajectory can only be executed from (close to) its start pose and with the control rate
+        const Affine trajectory_start {trajectory->path.pose(0.0)};
+        const Affine start {initial_pose * frame};
+        const double translation_difference = (trajectory_start.translation() - start.translation()).norm();
+        const double rotation_difference = trajectory_start.quaternion().angularDistance(start.quaternion());
+        if (translation_difference > 1e-3 || rotation_difference > 1e-2 || std::abs(trajectory->delta_time - control_rate) > 1e-9) {
+            std::cout << "Precomputed trajectory does not start at the current pose or was parametrized with a different control rate." << std::endl;
+            return false;
+        }
+    }
+
     Waypoint start_waypoint {initial_pose * frame, initial_cartesian_pose.elbow[0]};
     auto all_waypoints = motion.waypoints;
     all_waypoints.insert(all_waypoints.begin(), start_waypoint);
 
-    // Create path
-    const Path path {all_waypoints};
-
-    // Get time parametrization
     TimeParametrization time_parametrization {control_rate};
-    const auto [max_velocity, max_acceleration, max_jerk] = getInputLimits(data);
-    const auto trajectory = time_parametrization.parametrize(path, max_velocity, max_acceleration, max_jerk);
+    time_parametrization.max_tool_velocity = motion.max_tool_velocity.value_or(std::numeric_limits<double>::infinity());
+    const auto [max_velocity, max_acceleration, max_jerk] = getInputLimits(data, motion.stream_joint_positions);
+    const bool plan_ahead = motion.check_joint_limits || motion.stream_joint_positions || motion.optimize_elbow;
+
+    // Reuse a trajectory planned before from the same inputs and (nearly) the same start pose, which is then moved to
+    // start exactly at the current pose as well
+    std::optional<TrajectoryCache::Key> cache_key;
+    std::shared_ptr<const Trajectory> cached_trajectory;
+    if (!trajectory && trajectory_cache) {
+        // Trajectories planned in joint space depend on the start joint positions as well
+        const auto q_start = plan_ahead ? std::optional<Vector7d>(initial_state.q_d.data()) : std::nullopt;
+        cache_key = TrajectoryCache::get_key(motion.waypoints, motion.interpolation, frame, max_velocity, max_acceleration, max_jerk, control_rate, time_parametrization.max_tool_velocity, plan_ahead, motion.optimize_elbow, q_start);
+        cached_trajectory = trajectory_cache->find(*cache_key, initial_pose * frame);
+    }
+
+    // Precomputed states, either from the trajectory file or the cache
+    const Trajectory::State* precomputed_states {nullptr};
+    size_t precomputed_size {0};
+    if (trajectory) {
+        precomputed_states = trajectory->begin();
+        precomputed_size = trajectory->size();
+    } else if (cached_trajectory) {
+        precomputed_states = cached_trajectory->states.data();
+        precomputed_size = cached_trajectory->states.size();
+    }
+
+    // Create path, or take the one of the precomputed trajectory
+    const Path path = trajectory ? trajectory->path : (cached_trajectory ? cached_trajectory->path : Path(all_waypoints, motion.interpolation));
+
+    // A precomputed trajectory is moved rigidly so that it starts exactly at the current commanded pose, otherwise the
+    // first command would jump by the remaining difference
+    Affine path_origin;
+    if (trajectory || cached_trajectory) {
+        path_origin = initial_pose * frame * path.pose(0.0).inverse();
+    }
+
+    // Profile of the last joint along the path, which moves the elbow away from singularities and the joint limits
+    const Kinematics kinematics {Affine(initial_state.F_T_EE)};
+    std::optional<RedundancyProfile> redundancy;
+    if (motion.optimize_elbow) {
+        try {
+            redundancy = ElbowOptimizer(kinematics).optimize(path, frame, Vector7d(initial_state.q_d.data()));
+
+        } catch (const std::runtime_error& error) {
+            std::cout << error.what() << std::endl;
+            return false;
+        }
+    }
+
+    // Plan the whole trajectory ahead to slow down where the joint limits would be exceeded
+    std::shared_ptr<Trajectory> checked_trajectory;
+    if (!precomputed_states && plan_ahead) {
+        // Joint position and elbow commands need to keep the joint jerk limits as well
+        JointLimitCheck joint_limit_check {kinematics, max_joint_velocity, max_joint_acceleration, max_joint_jerk};
+        joint_limit_check.redundancy = redundancy;
+        try {
+            checked_trajectory = std::make_shared<Trajectory>(joint_limit_check.parametrize(time_parametrization, path, frame, Vector7d(initial_state.q_d.data()), max_velocity, max_acceleration, max_jerk));
+
+        } catch (const std::runtime_error& error) {
+            std::cout << error.what() << std::endl;
+            return false;
+        }
+        precomputed_states = checked_trajectory->states.data();
+        precomputed_size = checked_trajectory->states.size();
+    }
+
+    // Map the precomputed trajectory to joint positions, so that the robot follows them (or their elbow) instead of its
+    // own inverse kinematics. The joint limits were only checked for these joint positions, with the last joint given by
+    // the start or the optimized elbow.
+    std::vector<Vector7d> joint_trajectory;
+    if (plan_ahead) {
+        Trajectory cartesian_trajectory {path};
+        cartesian_trajectory.states.assign(precomputed_states, precomputed_states + precomputed_size);
+
+        JointTrajectoryConversion conversion {kinematics, max_joint_velocity, max_joint_acceleration, max_joint_jerk};
+        conversion.redundancy = redundancy;
+        try {
+            joint_trajectory = conversion.convert(cartesian_trajectory, frame, Vector7d(initial_state.q_d.data()));
+
+        } catch (const std::runtime_error& error) {
+            std::cout << error.what() << std::endl;
+            return false;
+        }
+    }
+
+    // Otherwise, get the time parametrization calculated step by step within the control loop
+    std::optional<TimeParametrization::Stream> stream;
+    if (!precomputed_states) {
+        stream.emplace(time_parametrization.stream(path, max_velocity, max_acceleration, max_jerk));
+    }
+    bool has_appended_waypoints {false};
 
     const bool use_elbow {false};
 
+    // The stream extends its path with appended waypoints
+    const Path& current_path = stream ? stream->get_path() : path;
+
     double time {0.0};
     size_t trajectory_index {0};
+
+    // The pose is evaluated directly from the path, only the elbow needs its vector representation. An optimized elbow
+    // is the third joint of the converted trajectory, keeping the sign of the fourth joint.
+    auto target_pose = [&](double s) {
+        if (!joint_trajectory.empty()) {
+            const double elbow = joint_trajectory[std::min(trajectory_index, joint_trajectory.size() - 1)](2);
+            return franka::CartesianPose((path_origin * current_path.pose(s, frame)).array(), {elbow, initial_cartesian_pose.elbow[1]});
+        }
+        if (use_elbow) {
+            return CartesianPose(current_path.q(s, frame), use_elbow);
+        }
+        return franka::CartesianPose((path_origin * current_path.pose(s, frame)).array());
+    };
+
     double s_current {0.0};
     auto motion_generator = [&](const franka::RobotState& robot_state, franka::Duration period) -> franka::CartesianPose {
         time += period.toSec();
@@ -50,23 +169,74 @@ bool Robot::move(const Affine& frame, PathMotion motion, MotionData& data) {
 #endif
 
         const int steps = std::max<int>(period.toMSec(), 1);
-        trajectory_index += steps;
-        if (trajectory_index >= trajectory.states.size()) {
-            s_current = path.get_length();
-            return franka::MotionFinished(CartesianPose(path.q(s_current, frame), use_elbow));
+        bool is_finished;
+        if (precomputed_states) {
+            trajectory_index += steps;
+            is_finished = (trajectory_index >= precomputed_size);
+        } else {
+            // Take appended waypoints without blocking the control loop, they are taken in the next cycle otherwise
+            std::unique_lock<std::mutex> lock {motion.append_queue->mutex, std::try_to_lock};
+            if (lock.owns_lock() && !motion.append_queue->pending.empty()) {
+                for (const auto& [waypoints, blend_max_distance]: motion.append_queue->pending) {
+                    stream->append(waypoints, blend_max_distance);
+                }
+                motion.append_queue->pending.clear();
+
+                // The path does not match the cache key anymore
+                has_appended_waypoints = true;
+            }
+
+            for (int i = 0; i < steps && !stream->is_finished(); i += 1) {
+                stream->step();
+            }
+            is_finished = stream->is_finished();
         }
 
-        s_current = trajectory.states[trajectory_index].s;
-        return CartesianPose(path.q(s_current, frame), use_elbow);
+        if (is_finished) {
+            s_current = current_path.get_length();
+            return franka::MotionFinished(target_pose(s_current));
+        }
+
+        s_current = precomputed_states ? precomputed_states[trajectory_index].s : stream->get_state().s;
+        return target_pose(s_current);
+    };
+
+    std::array<double, 7> joint_positions;
+    auto joint_motion_generator = [&](const franka::RobotState& robot_state, franka::Duration period) -> franka::JointPositions {
+#ifdef WITH_PYTHON
+        if (stop_at_python_signal && Py_IsInitialized() && PyErr_CheckSignals() == -1) {
+            stop();
+        }
+#endif
+
+        trajectory_index = std::min<size_t>(trajectory_index + std::max<int>(period.toMSec(), 1), joint_trajectory.size() - 1);
+        Eigen::VectorXd::Map(&joint_positions[0], 7) = joint_trajectory[trajectory_index];
+
+        if (trajectory_index + 1 >= joint_trajectory.size()) {
+            return franka::MotionFinished(franka::JointPositions(joint_positions));
+        }
+        return franka::JointPositions(joint_positions);
     };
 
     try {
-        control(motion_generator, controller_mode);
+        if (motion.stream_joint_positions) {
+            control(joint_motion_generator, controller_mode);
+        } else {
+            control(motion_generator, controller_mode);
+        }
 
     } catch (franka::Exception exception) {
         std::cout << exception.what() << std::endl;
         return false;
     }
+
+    // The streamed states are not recorded within the control loop, as the trajectory grows without bound there. The path
+    // is parametrized once more after the motion instead.
+    if (stream && cache_key && stream->is_finished() && !has_appended_waypoints) {
+        trajectory_cache->insert(*cache_key, initial_pose * frame, std::make_shared<Trajectory>(time_parametrization.parametrize(path, max_velocity, max_acceleration, max_jerk)));
+    } else if (checked_trajectory && cache_key) {
+        trajectory_cache->insert(*cache_key, initial_pose * frame, checked_trajectory);
+    }
     return true;
 }
 
@@ -0,0 +1,298 @@
+#include <movex/path/collision_check.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+
+namespace movex {
+
+namespace {
+
+//! Distance between the segment from a to b and the box with the given half size around the origin. The squared
+//! distance is a convex quadratic function along the segment between the points where it crosses a face plane.
+double segment_box_distance(const Eigen::Vector3d& a, const Eigen::Vector3d& b, const Eigen::Vector3d& half_size) {
+    const Eigen::Vector3d direction = b - a;
+
+    // Both ends and at most two crossings per axis. Unused entries stay at the end, so that the whole array is sorted.
+    std::array<double, 2 + 2 * 3> breakpoints;
+    breakpoints.fill(1.0);
+    size_t count {2};
+    breakpoints[0] = 0.0;
+    for (size_t j = 0; j < 3; j += 1) {
+        if (direction(j) == 0.0) {
+            continue;
+        }
+        for (const double face: {-half_size(j), half_size(j)}) {
+            const double t = (face - a(j)) / direction(j);
+            if (0.0 < t && t < 1.0) {
+                breakpoints[count++] = t;
+            }
+        }
+    }
+    std::sort(breakpoints.begin(), breakpoints.end());
+
+    double min_squared {std::numeric_limits<double>::infinity()};
+    for (size_t i = 0; i + 1 < count; i += 1) {
+        const double t_start = breakpoints[i], t_end = breakpoints[i + 1];
+        const double t_mid = (t_start + t_end) / 2;
+
+        // Coefficients of the squared distance c2 t^2 + c1 t + c0 within the interval
+        double c2 {0.0}, c1 {0.0}, c0 {0.0};
+        for (size_t j = 0; j < 3; j += 1) {
+            const double x = a(j) + t_mid * direction(j);
+            if (std::abs(x) <= half_size(j)) {
+                continue;
+            }
+
+            const double u = a(j) - std::copysign(half_size(j), x);
+            c2 += direction(j) * direction(j);
+            c1 += 2 * u * direction(j);
+            c0 += u * u;
+        }
+
+        const double t = (c2 > 0.0) ? std::clamp(-c1 / (2 * c2), t_start, t_end) : t_start;
+        min_squared = std::min(min_squared, (c2 * t + c1) * t + c0);
+    }
+    return std::sqrt(std::max(min_squared, 0.0));
+}
+
+
+//! Joint positions along the path, from the inverse kinematics
+struct Sample {
+    double s;
+    Vector7d q;
+    double distance;
+};
+
+class TrajectoryCheck {
+    const CollisionCheck& collision;
+    const Path& path;
+    const Affine& frame;
+    double q7_start;
+
+    //! Upper bound of the distance of any point of the robot to each joint axis
+    Vector7d reach;
+
+public:
+    explicit TrajectoryCheck(const CollisionCheck& collision, const Path& path, const Affine& frame, double q7_start): collision(collision), path(path), frame(frame), q7_start(q7_start) {
+        reach.setZero();
+        for (const auto& [index, capsule]: collision.link_capsules) {
+            double length = std::max(capsule.start.norm(), capsule.end.norm()) + capsule.radius;
+            for (size_t i = std::min<size_t>(index, 7); i-- > 0;) {
+                const auto& [a, d, alpha] = Kinematics::dh_parameters[i + 1];
+                length += std::hypot(a, d);
+                reach(i) = std::max(reach(i), length);
+            }
+            if (index < 7) {
+                reach(index) = std::max(reach(index), std::max(capsule.start.norm(), capsule.end.norm()) + capsule.radius);
+            }
+        }
+    }
+
+    //! Returns the sample at s, and throws if its pose is unreachable, as the robot cannot follow the trajectory then
+    Sample sample(double s, const Vector7d& q_reference) const {
+        const double q7 = collision.redundancy ? collision.redundancy->q7(s) : q7_start;
+        const auto q = collision.kinematics.inverse(path.pose(s, frame), q7, q_reference);
+        if (!q) {
+            throw std::runtime_error("Pose at s = " + std::to_string(s) + " is not reachable within the joint limits.");
+        }
+        return Sample {s, *q, collision.distance(*q)};
+    }
+
+    //! Returns the first sample in contact after the sample start up to the sample end
+    std::optional<Sample> first_contact(const Sample& start, const Sample& end) const {
+        const bool is_contact = end.distance < collision.min_distance;
+        const double sweep = ((end.q - start.q).cwiseAbs().array() * reach.array()).sum();
+        if (!is_contact && start.distance + end.distance - sweep >= 2 * collision.min_distance) {
+            return std::nullopt;
+        }
+
+        if (end.s - start.s > collision.s_resolution) {
+            const auto middle = sample((start.s + end.s) / 2, start.q);
+            if (const auto contact = first_contact(start, middle)) {
+                return contact;
+            }
+            return first_contact(middle, end);
+        }
+
+        if (is_contact) {
+            return end;
+        }
+        return std::nullopt;
+    }
+};
+
+} // namespace
+
+
+std::vector<CollisionCheck::LinkCapsule> CollisionCheck::panda_capsules() {
+    // Following the collision geometry of the official robot description, the hand is rotated by -45 deg
+    const double hand = 0.075 * std::sqrt(0.5);
+    return {
+        {0, {{0.0, 0.0, -0.19}, {0.0, 0.0, -0.05}, 0.06}},
+        {1, {{0.0, 0.0, -0.06}, {0.0, 0.0, 0.06}, 0.06}},
+        {2, {{0.0, 0.0, -0.22}, {0.0, 0.0, -0.07}, 0.06}},
+        {3, {{0.0, 0.0, -0.06}, {0.0, 0.0, 0.06}, 0.06}},
+        {4, {{0.0, 0.0, -0.31}, {0.0, 0.0, -0.21}, 0.06}},
+        {4, {{0.0, 0.08, -0.20}, {0.0, 0.08, -0.06}, 0.025}},
+        {5, {{0.0, 0.0, -0.07}, {0.0, 0.0, 0.01}, 0.05}},
+        {6, {{0.0, 0.0, -0.06}, {0.0, 0.0, 0.08}, 0.04}},
+        {7, {{-hand, -hand, 0.04}, {hand, hand, 0.04}, 0.04}},
+    };
+}
+
+void CollisionCheck::add_plane(const Eigen::Vector3d& normal, double offset) {
+    if (plane_count % block_size == 0) {
+        // Unused entries of a block have a zero normal and are infinitely far away
+        PlaneBlock block;
+        for (auto& lane: block.normal) {
+            lane.setZero();
+        }
+        block.offset.setConstant(-std::numeric_limits<double>::infinity());
+        planes.push_back(block);
+    }
+
+    const double norm = normal.norm();
+    auto& block = planes.back();
+    const size_t i = plane_count % block_size;
+    for (size_t j = 0; j < 3; j += 1) {
+        block.normal[j](i) = normal(j) / norm;
+    }
+    block.offset(i) = offset / norm;
+    plane_count += 1;
+}
+
+void CollisionCheck::add_box(const Affine& pose, const Eigen::Vector3d& size) {
+    boxes.push_back({pose.data.linear().transpose(), pose.data.translation(), size / 2, size.norm() / 2});
+}
+
+void CollisionCheck::add_capsule(const Eigen::Vector3d& start, const Eigen::Vector3d& end, double radius) {
+    if (capsule_count % block_size == 0) {
+        // Unused entries of a block are spheres far away
+        CapsuleBlock block;
+        for (size_t j = 0; j < 3; j += 1) {
+            block.start[j].setConstant(1e6);
+            block.end[j].setConstant(1e6);
+        }
+        block.radius.setZero();
+        capsules.push_back(block);
+    }
+
+    auto& block = capsules.back();
+    const size_t i = capsule_count % block_size;
+    for (size_t j = 0; j < 3; j += 1) {
+        block.start[j](i) = start(j);
+        block.end[j](i) = end(j);
+    }
+    block.radius(i) = radius;
+    capsule_count += 1;
+}
+
+void CollisionCheck::clear_obstacles() {
+    planes.clear();
+    capsules.clear();
+    boxes.clear();
+    plane_count = 0;
+    capsule_count = 0;
+}
+
+double CollisionCheck::capsule_distance(const Eigen::Vector3d& a, const Eigen::Vector3d& b, double r) const {
+    constexpr double epsilon {1e-12};
+    double result {std::numeric_limits<double>::infinity()};
+
+    for (const auto& block: planes) {
+        const Lane distance_a = block.normal[0] * a(0) + block.normal[1] * a(1) + block.normal[2] * a(2);
+        const Lane distance_b = block.normal[0] * b(0) + block.normal[1] * b(1) + block.normal[2] * b(2);
+        result = std::min(result, (distance_a.min(distance_b) - block.offset).minCoeff() - r);
+    }
+
+    // Closest points between the segments a + s d1 and start + t d2 (Ericson, Real-Time Collision Detection, 5.1.9),
+    // with the branches as selections
+    const Eigen::Vector3d d1 = b - a;
+    const double aa = std::max(d1.squaredNorm(), epsilon);
+    for (const auto& block: capsules) {
+        std::array<Lane, 3> d2, r0;
+        for (size_t j = 0; j < 3; j += 1) {
+            d2[j] = block.end[j] - block.start[j];
+            r0[j] = a(j) - block.start[j];
+        }
+
+        const Lane e = (d2[0].square() + d2[1].square() + d2[2].square()).max(epsilon);
+        const Lane f = d2[0] * r0[0] + d2[1] * r0[1] + d2[2] * r0[2];
+        const Lane c = d1(0) * r0[0] + d1(1) * r0[1] + d1(2) * r0[2];
+        const Lane bb = d1(0) * d2[0] + d1(1) * d2[1] + d1(2) * d2[2];
+        const Lane denominator = aa * e - bb.square();
+
+        const Lane s_initial = (denominator > epsilon).select((bb * f - c * e) / denominator, -c / aa).max(0.0).min(1.0);
+        const Lane t_unclamped = (bb * s_initial + f) / e;
+        const Lane t = t_unclamped.max(0.0).min(1.0);
+        const Lane s = (t_unclamped == t).select(s_initial, ((bb * t - c) / aa).max(0.0).min(1.0));
+
+        Lane squared_distance = Lane::Zero();
+        for (size_t j = 0; j < 3; j += 1) {
+            squared_distance += (r0[j] + s * d1(j) - t * d2[j]).square();
+        }
+        result = std::min(result, (squared_distance.sqrt() - block.radius).minCoeff() - r);
+    }
+
+    // Boxes are skipped if their bounding sphere is farther away than the closest obstacle so far
+    const Eigen::Vector3d center = (a + b) / 2;
+    const double half_length = d1.norm() / 2;
+    for (const auto& box: boxes) {
+        if ((center - box.center).norm() - half_length - box.radius - r >= result) {
+            continue;
+        }
+
+        const Eigen::Vector3d box_a = box.rotation_inverse * (a - box.center);
+        const Eigen::Vector3d box_b = box.rotation_inverse * (b - box.center);
+        result = std::min(result, segment_box_distance(box_a, box_b, box.half_size) - r);
+    }
+    return result;
+}
+
+double CollisionCheck::distance(const Vector7d& q) const {
+    const auto frames = Kinematics::joint_frames(q);
+
+    double result {std::numeric_limits<double>::infinity()};
+    for (const auto& [index, capsule]: link_capsules) {
+        const Eigen::Matrix3d rotation = frames[index].block<3, 3>(0, 0);
+        const Eigen::Vector3d translation = frames[index].block<3, 1>(0, 3);
+        result = std::min(result, capsule_distance(rotation * capsule.start + translation, rotation * capsule.end + translation, capsule.radius));
+    }
+    return result;
+}
+
+std::optional<CollisionCheck::Contact> CollisionCheck::check(const Trajectory& trajectory, const Affine& frame, const Vector7d& q_start) const {
+    if (trajectory.states.empty()) {
+        return std::nullopt;
+    }
+
+    const TrajectoryCheck check {*this, trajectory.path, frame, q_start(6)};
+    const double s_start = trajectory.states.front().s, s_end = trajectory.states.back().s;
+
+    auto contact_at = [&](const Sample& sample) {
+        // Last state before the contact, as the path position is increasing
+        const auto state = std::partition_point(trajectory.states.begin() + 1, trajectory.states.end(), [&sample](const Trajectory::State& state) { return state.s <= sample.s; }) - 1;
+        return Contact {state->t, sample.s, sample.distance};
+    };
+
+    auto previous = check.sample(s_start, q_start);
+    if (previous.distance < min_distance) {
+        return contact_at(previous);
+    }
+
+    for (double s = s_start; s < s_end;) {
+        s = std::min(s + s_step, s_end);
+        const auto current = check.sample(s, previous.q);
+        if (const auto contact = check.first_contact(previous, current)) {
+            return contact_at(*contact);
+        }
+        previous = current;
+    }
+    return std::nullopt;
+}
+
+} // namespace movex
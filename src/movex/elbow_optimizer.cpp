@@ -0,0 +1,167 @@
+#include <movex/path/elbow_optimizer.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace movex {
+
+double ElbowOptimizer::cost(const Vector7d& q) const {
+    // Logarithm of the normalized distance to both joint limits, which is zero in the middle of the range
+    double margin {0.0};
+    for (size_t j = 0; j < 7; j += 1) {
+        const double range = Kinematics::max_joint_position[j] - Kinematics::min_joint_position[j];
+        margin += std::log(4 * (q(j) - Kinematics::min_joint_position[j]) * (Kinematics::max_joint_position[j] - q(j)) / std::pow(range, 2));
+    }
+    return -std::log(Kinematics::manipulability(kinematics.jacobian(q))) - limit_weight * margin;
+}
+
+RedundancyProfile ElbowOptimizer::optimize(const Path& path, const Affine& frame, const Vector7d& q_start) const {
+    const double length = path.get_length();
+    const size_t knots = std::max<size_t>(std::ceil(length / s_step - 1e-9), 1) + 1;
+    const size_t substeps = std::max<size_t>(std::ceil(s_step / s_resolution - 1e-9), 1);
+    const size_t samples = (knots - 1) * substeps + 1;
+    const double h = length / (knots - 1), ds = h / substeps;
+
+    // Candidates q7_start + (k - k0) q7_step within the joint limits and the range that the slope limit reaches
+    const double q7_start = q_start(6);
+    const double q7_range = max_pdq7 * length;
+    const size_t k0 = std::floor(std::min(q7_start - Kinematics::min_joint_position[6], q7_range) / q7_step);
+    const size_t candidates = k0 + 1 + std::floor(std::min(Kinematics::max_joint_position[6] - q7_start, q7_range) / q7_step);
+    auto q7 = [&](size_t k) {
+        return q7_start + (double(k) - double(k0)) * q7_step;
+    };
+
+    // Joint positions and their cost on the dense grid. Each candidate follows its branch of the inverse kinematics
+    // continuously, first along q7 at the start and then along the path.
+    struct Sample {
+        std::optional<Vector7d> q;
+        double cost {std::numeric_limits<double>::infinity()};
+    };
+    std::vector<Sample> grid(samples * candidates);
+    auto sample = [&](size_t j, size_t k) -> Sample& {
+        return grid[j * candidates + k];
+    };
+    auto solve = [&](size_t j, size_t k, const Affine& pose, const std::optional<Vector7d>& reference) {
+        auto& current = sample(j, k);
+        if (reference) {
+            current.q = kinematics.inverse(pose, q7(k), *reference);
+        }
+        if (current.q) {
+            current.cost = cost(*current.q);
+        }
+    };
+
+    const Affine start_pose = path.pose(0.0, frame);
+    solve(0, k0, start_pose, q_start);
+    if (!sample(0, k0).q) {
+        throw std::runtime_error("Path does not start at a reachable pose.");
+    }
+    for (size_t k = k0; k-- > 0;) {
+        solve(0, k, start_pose, sample(0, k + 1).q);
+    }
+    for (size_t k = k0 + 1; k < candidates; k += 1) {
+        solve(0, k, start_pose, sample(0, k - 1).q);
+    }
+    for (size_t j = 1; j < samples; j += 1) {
+        const Affine pose = path.pose(std::min(j * ds, length), frame);
+        for (size_t k = 0; k < candidates; k += 1) {
+            solve(j, k, pose, sample(j - 1, k).q);
+        }
+    }
+
+    // Cost of a linear change of q7 between two knots, integrated over the dense samples in between
+    auto section_cost = [&](size_t i, size_t k_start, size_t k_end) {
+        double result {0.0};
+        const Sample* previous = &sample(i * substeps, k_start);
+        for (size_t m = 1; m <= substeps; m += 1) {
+            const double k = k_start + (double(k_end) - double(k_start)) * m / substeps;
+            const Sample& current = sample(i * substeps + m, std::lround(k));
+            if (!std::isfinite(current.cost) || !std::isfinite(previous->cost)) {
+                return std::numeric_limits<double>::infinity();
+            }
+
+            result += ds * current.cost + velocity_weight * (*current.q - *previous->q).squaredNorm() / ds;
+            previous = &current;
+        }
+        return result;
+    };
+
+    // Dynamic program over the knots with the state (k, slope), so that both the slope and the curvature of the
+    // profile are limited by the change of k between two knots
+    const int max_slope = std::floor(max_pdq7 * h / q7_step + 1e-9);
+    const int max_curvature = std::floor(max_pddq7 * std::pow(h, 2) / q7_step + 1e-9);
+    const size_t slopes = 2 * max_slope + 1;
+
+    struct Node {
+        double cost {std::numeric_limits<double>::infinity()};
+        int previous_slope;
+    };
+    std::vector<Node> nodes(knots * candidates * slopes);
+    auto node = [&](size_t i, size_t k, int slope) -> Node& {
+        return nodes[(i * candidates + k) * slopes + (slope + max_slope)];
+    };
+
+    // The profile might start with any slope, as the path velocity is zero there
+    for (int slope = -max_slope; slope <= max_slope; slope += 1) {
+        node(0, k0, slope).cost = 0.0;
+    }
+    for (size_t i = 1; i < knots; i += 1) {
+        for (size_t k_previous = 0; k_previous < candidates; k_previous += 1) {
+            for (int previous_slope = -max_slope; previous_slope <= max_slope; previous_slope += 1) {
+                const auto& previous = node(i - 1, k_previous, previous_slope);
+                if (!std::isfinite(previous.cost)) {
+                    continue;
+                }
+
+                const int slope_min = std::max(previous_slope - max_curvature, -max_slope);
+                const int slope_max = std::min(previous_slope + max_curvature, max_slope);
+                for (int slope = slope_min; slope <= slope_max; slope += 1) {
+                    const int k = int(k_previous) + slope;
+                    if (k < 0 || k >= int(candidates)) {
+                        continue;
+                    }
+
+                    auto& current = node(i, k, slope);
+                    const double cost = previous.cost + section_cost(i - 1, k_previous, k);
+                    if (cost < current.cost) {
+                        current.cost = cost;
+                        current.previous_slope = previous_slope;
+                    }
+                }
+            }
+        }
+    }
+
+    size_t k_best {0};
+    int slope_best {0};
+    for (size_t k = 0; k < candidates; k += 1) {
+        for (int slope = -max_slope; slope <= max_slope; slope += 1) {
+            if (node(knots - 1, k, slope).cost < node(knots - 1, k_best, slope_best).cost) {
+                k_best = k;
+                slope_best = slope;
+            }
+        }
+    }
+    if (!std::isfinite(node(knots - 1, k_best, slope_best).cost)) {
+        throw std::runtime_error("Path cannot be followed with any elbow from the start joint positions.");
+    }
+
+    std::vector<double> profile(knots);
+    for (size_t i = knots, k = k_best; i-- > 0;) {
+        profile[i] = q7(k);
+        if (i > 0) {
+            const int slope = slope_best;
+            slope_best = node(i, k, slope).previous_slope;
+            k -= slope;
+        }
+    }
+    return RedundancyProfile(h, profile);
+}
+
+} // namespace movex
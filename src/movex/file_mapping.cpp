@@ -0,0 +1,48 @@
+#include <movex/file_mapping.hpp>
+
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace movex {
+
+FileMapping::FileMapping(const std::string& filename) {
+    const int descriptor = ::open(filename.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        throw std::runtime_error("Could not open file " + filename + ".");
+    }
+
+    struct stat status;
+    if (::fstat(descriptor, &status) != 0 || status.st_size == 0) {
+        ::close(descriptor);
+        throw std::runtime_error("File " + filename + " is empty or unreadable.");
+    }
+
+    // Read all pages on mapping, so that no page faults occur when the data is used within the control loop
+    int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE;
+#endif
+
+    void* address = ::mmap(nullptr, status.st_size, PROT_READ, flags, descriptor, 0);
+    ::close(descriptor);
+    if (address == MAP_FAILED) {
+        throw std::runtime_error("Could not map file " + filename + ".");
+    }
+
+    data = static_cast<const char*>(address);
+    size = status.st_size;
+
+    // Keep the pages in memory, this needs a sufficient limit of locked memory (as for the real-time kernel)
+    is_locked = (::mlock(address, size) == 0);
+}
+
+FileMapping::~FileMapping() {
+    ::munmap(const_cast<char*>(data), size);
+}
+
+} // namespace movex
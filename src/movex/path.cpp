@@ -1,5 +1,7 @@
 #include <movex/path/path.hpp>
 
+#include <algorithm>
+
 
 namespace movex {
 
@@ -16,79 +18,273 @@ std::tuple<std::shared_ptr<Segment>, double> Path::get_local(double s) const {
     return {segment, s_local};
 }
 
-void Path::init_path_points(const std::vector<Waypoint>& waypoints) {
+std::vector<Waypoint> Path::convert_affines(const std::vector<Affine>& affines, double blend_max_distance) {
+    std::vector<Waypoint> converted(affines.size());
+    for (size_t i = 0; i < affines.size(); i += 1) {
+        converted[i] = Waypoint(affines[i], std::nullopt, blend_max_distance);
+    }
+    return converted;
+}
+
+std::vector<Vector7d> Path::get_target_vectors(const std::vector<Waypoint>& waypoints) {
     if (waypoints.size() < 2) {
         throw std::runtime_error("Path needs at least 2 waypoints as input, but has only " + std::to_string(waypoints.size()) + ".");
     }
 
-    std::vector<std::shared_ptr<LineSegment>> line_segments;
+    std::vector<Vector7d> vectors;
+    vectors.reserve(waypoints.size());
 
     double elbow_current = waypoints[0].elbow.value_or(0.0);
     Affine affine_current = waypoints[0].affine;
 
-    Vector7d vector_current = waypoints[0].getTargetVector(affine_current, elbow_current);
-    Vector7d vector_next;
-
+    vectors.emplace_back(waypoints[0].getTargetVector(affine_current, elbow_current));
     for (size_t i = 1; i < waypoints.size(); i += 1) {
-        vector_next = waypoints[i].getTargetVector(affine_current, elbow_current);
+        Vector7d vector_next = waypoints[i].getTargetVector(affine_current, elbow_current);
         affine_current = Affine(vector_next);
         elbow_current = vector_next(6);
-
-        auto segment = std::make_shared<LineSegment>(vector_current, vector_next);
-        line_segments.emplace_back(segment);
-        std::swap(vector_current, vector_next);
+        vectors.emplace_back(vector_next);
     }
+    return vectors;
+}
+
+void Path::add_segment(const std::shared_ptr<Segment>& segment) {
+    length += segment->get_length();
+    segments.emplace_back(segment);
+    cumulative_lengths.emplace_back(length);
+}
+
+void Path::add_blended_lines(std::vector<std::shared_ptr<LineSegment>> line_segments, const std::vector<double>& blend_max_distances, double first_s_abs_max) {
+    for (size_t i = 1; i < line_segments.size(); i += 1) {
+        auto& left = line_segments[i - 1];
+        auto& right = line_segments[i];
 
-    double cumulative_length {0.0};
-    for (size_t i = 1; i < waypoints.size() - 1; i += 1) {
-        if (waypoints[i].blend_max_distance > 0.0) {
-            auto& left = line_segments[i - 1];
-            auto& right = line_segments[i];
+        double s_abs_max = std::min<double>({ left->get_length() / 2, right->get_length() / 2 });
+        if (i == 1) {
+            s_abs_max = std::min(s_abs_max, first_s_abs_max);
+        }
 
+        if (blend_max_distances[i - 1] > 0.0 && s_abs_max > 0.0) {
             Vector7d lm = (left->end - left->start) / left->get_length();
             Vector7d rm = (right->end - right->start) / right->get_length();
 
-            double s_abs_max = std::min<double>({ left->get_length() / 2, right->get_length() / 2 });
-
-            auto blend = std::make_shared<QuarticBlendSegment>(left->start, lm, right->start, rm, left->get_length(), waypoints[i].blend_max_distance, s_abs_max);
+            auto blend = std::make_shared<QuarticBlendSegment>(left->start, lm, right->start, rm, left->get_length(), blend_max_distances[i - 1], s_abs_max);
             double s_abs = blend->get_length() / 2;
 
             auto new_left = std::make_shared<LineSegment>(left->start, left->q(left->get_length() - s_abs));
             auto new_right = std::make_shared<LineSegment>(right->q(s_abs), right->end);
 
-            cumulative_length += new_left->get_length();
-            segments.emplace_back(new_left);
-            cumulative_lengths.emplace_back(cumulative_length);
-
-            cumulative_length += blend->get_length();
-            segments.emplace_back(blend);
-            cumulative_lengths.emplace_back(cumulative_length);
+            add_segment(new_left);
+            add_segment(blend);
 
             right = new_right;
 
         } else {
-            cumulative_length += line_segments[i - 1]->get_length();
-            segments.emplace_back(line_segments[i - 1]);
-            cumulative_lengths.emplace_back(cumulative_length);
+            add_segment(left);
         }
     }
 
-    cumulative_length += line_segments.back()->get_length();
-    segments.emplace_back(line_segments.back());
-    cumulative_lengths.emplace_back(cumulative_length);
-    length = cumulative_length;
+    add_segment(line_segments.back());
+}
+
+void Path::init_lines(const std::vector<Vector7d>& vectors, const std::vector<double>& blend_max_distances) {
+    std::vector<std::shared_ptr<LineSegment>> line_segments;
+    for (size_t i = 1; i < vectors.size(); i += 1) {
+        line_segments.emplace_back(std::make_shared<LineSegment>(vectors[i - 1], vectors[i]));
+    }
+
+    add_blended_lines(line_segments, blend_max_distances, std::numeric_limits<double>::infinity());
+}
+
+void Path::init_path_points(const std::vector<Waypoint>& waypoints) {
+    const auto vectors = get_target_vectors(waypoints);
+
+    std::vector<double> blend_max_distances;
+    for (size_t i = 1; i < vectors.size(); i += 1) {
+        blend_max_distances.emplace_back(waypoints[i].blend_max_distance);
+    }
+
+    init_lines(vectors, blend_max_distances);
+}
+
+void Path::init_quintic_spline(const std::vector<Waypoint>& waypoints) {
+    const auto vectors = get_target_vectors(waypoints);
+    const size_t n = vectors.size();
+
+    // The spline is parametrized by the chord length between consecutive waypoints
+    std::vector<double> chord_lengths(n - 1);
+    for (size_t i = 0; i < n - 1; i += 1) {
+        chord_lengths[i] = (vectors[i + 1] - vectors[i]).norm();
+    }
+
+    // Tangents (first path derivative) at the waypoints by a weighted average of the adjacent chords
+    std::vector<Vector7d> tangents(n);
+    tangents[0] = (vectors[1] - vectors[0]) / chord_lengths[0];
+    tangents[n - 1] = (vectors[n - 1] - vectors[n - 2]) / chord_lengths[n - 2];
+    for (size_t i = 1; i < n - 1; i += 1) {
+        const double l = chord_lengths[i - 1], r = chord_lengths[i];
+        tangents[i] = (r * (vectors[i] - vectors[i - 1]) / l + l * (vectors[i + 1] - vectors[i]) / r) / (l + r);
+    }
+
+    // Curvatures (second path derivative) at the waypoints by weighting the ones of the adjacent cubic Hermite splines,
+    // so that both quintic segments share the same value and the path is curvature continuous.
+    std::vector<Vector7d> curvatures(n, Vector7d::Zero());
+    for (size_t i = 1; i < n - 1; i += 1) {
+        const double l = chord_lengths[i - 1], r = chord_lengths[i];
+        Vector7d left_end = (-6 * (vectors[i] - vectors[i - 1]) + (2 * tangents[i - 1] + 4 * tangents[i]) * l) / std::pow(l, 2);
+        Vector7d right_start = (6 * (vectors[i + 1] - vectors[i]) - (4 * tangents[i] + 2 * tangents[i + 1]) * r) / std::pow(r, 2);
+        curvatures[i] = (r * left_end + l * right_start) / (l + r);
+    }
+
+    for (size_t i = 0; i < n - 1; i += 1) {
+        add_segment(std::make_shared<QuinticSegment>(vectors[i], tangents[i], curvatures[i], vectors[i + 1], tangents[i + 1], curvatures[i + 1], chord_lengths[i]));
+    }
+}
+
+void Path::init_slerp(const std::vector<Waypoint>& waypoints) {
+    const auto vectors = get_target_vectors(waypoints);
+
+    for (size_t i = 1; i < vectors.size(); i += 1) {
+        const Affine start {vectors[i - 1]}, end {vectors[i]};
+        add_segment(std::make_shared<SlerpSegment>(start.translation(), start.quaternion(), vectors[i - 1](6), end.translation(), end.quaternion(), vectors[i](6)));
+    }
+}
+
+void Path::append(const std::vector<Waypoint>& waypoints, double blend_max_distance, double s_fixed) {
+    if (waypoints.empty()) {
+        return;
+    }
+
+    // Waypoints are relative to the current end of the path
+    const Vector7d end = q(length);
+    std::vector<Waypoint> all_waypoints {Waypoint(Affine(end), end(6))};
+    all_waypoints.insert(all_waypoints.end(), waypoints.begin(), waypoints.end());
+
+    auto vectors = get_target_vectors(all_waypoints);
+    vectors[0] = end;
+
+    if (const auto slerp = std::dynamic_pointer_cast<SlerpSegment>(segments.back())) {
+        Eigen::Vector3d start_translation {slerp->end_translation};
+        Eigen::Quaterniond start_rotation {slerp->end_rotation};
+        for (size_t i = 1; i < vectors.size(); i += 1) {
+            const Affine next {vectors[i]};
+            add_segment(std::make_shared<SlerpSegment>(start_translation, start_rotation, vectors[i - 1](6), next.translation(), next.quaternion(), vectors[i](6)));
+            start_translation = next.translation();
+            start_rotation = next.quaternion();
+        }
+        return;
+    }
+
+    std::vector<std::shared_ptr<LineSegment>> line_segments;
+    std::vector<double> blend_max_distances;
+    double first_s_abs_max {0.0};
+
+    // A line at the end is replaced, so that it can be blended into the new lines without changing the path before s_fixed
+    if (const auto line = std::dynamic_pointer_cast<LineSegment>(segments.back())) {
+        first_s_abs_max = length - s_fixed;
+
+        length -= line->get_length();
+        segments.pop_back();
+        cumulative_lengths.pop_back();
+
+        line_segments.emplace_back(line);
+        blend_max_distances.emplace_back(blend_max_distance);
+    }
+
+    for (size_t i = 1; i < vectors.size(); i += 1) {
+        line_segments.emplace_back(std::make_shared<LineSegment>(vectors[i - 1], vectors[i]));
+        blend_max_distances.emplace_back(all_waypoints[i].blend_max_distance);
+    }
+
+    add_blended_lines(line_segments, blend_max_distances, first_s_abs_max);
+}
+
+Path::Path(const std::vector<Waypoint>& waypoints, Interpolation interpolation) {
+    switch (interpolation) {
+        case Interpolation::Linear: {
+            init_path_points(waypoints);
+        } break;
+        case Interpolation::QuinticSpline: {
+            init_quintic_spline(waypoints);
+        } break;
+        case Interpolation::Slerp: {
+            init_slerp(waypoints);
+        } break;
+    }
+}
+
+Path::Path(const std::vector<Affine>& waypoints, double blend_max_distance): Path(convert_affines(waypoints, blend_max_distance)) { }
+
+Path::Path(const std::vector<Affine>& waypoints, Interpolation interpolation): Path(convert_affines(waypoints, 0.0), interpolation) { }
+
+Path::Path(const std::vector<std::shared_ptr<Segment>>& segments) {
+    if (segments.empty()) {
+        throw std::runtime_error("Path needs at least 1 segment as input.");
+    }
+
+    for (const auto& segment: segments) {
+        add_segment(segment);
+    }
 }
 
-Path::Path(const std::vector<Waypoint>& waypoints) {
-    init_path_points(waypoints);
+Path::Path(const std::vector<Vector7d>& vectors, double blend_max_distance) {
+    if (vectors.size() < 2) {
+        throw std::runtime_error("Path needs at least 2 waypoints as input, but has only " + std::to_string(vectors.size()) + ".");
+    }
+
+    init_lines(vectors, std::vector<double>(vectors.size() - 1, blend_max_distance));
 }
 
-Path::Path(const std::vector<Affine>& waypoints, double blend_max_distance) {
-    std::vector<Waypoint> converted(waypoints.size());
-    for (size_t i = 0; i < waypoints.size(); i += 1) {
-        converted[i] = Waypoint(waypoints[i], std::nullopt, blend_max_distance);
+std::vector<Waypoint> Path::simplify(const std::vector<Waypoint>& waypoints, double max_translation_deviation, double max_rotation_deviation) {
+    const auto vectors = get_target_vectors(waypoints);
+    const size_t n = vectors.size();
+
+    // Deviation of a vector from the line between two others at its nearest path parameter, relative to the tolerance
+    auto relative_deviation = [&](const Vector7d& start, const Vector7d& end, const Vector7d& vector) {
+        const Vector7d difference = end - start;
+        const double squared_length = difference.squaredNorm();
+        const double t = (squared_length > 0.0) ? std::clamp((vector - start).dot(difference) / squared_length, 0.0, 1.0) : 0.0;
+        const Vector7d interpolated = start + t * difference;
+
+        const double translation_deviation = (vector.head<3>() - interpolated.head<3>()).norm();
+        const double rotation_deviation = Affine(vector).quaternion().angularDistance(Affine(interpolated).quaternion());
+        const double elbow_deviation = std::abs(vector(6) - interpolated(6));
+        return std::max({translation_deviation / max_translation_deviation, rotation_deviation / max_rotation_deviation, elbow_deviation / max_rotation_deviation});
+    };
+
+    std::vector<bool> is_kept(n, false);
+    is_kept.front() = is_kept.back() = true;
+
+    // Split ranges at their most deviating waypoint, with an explicit stack instead of recursion for very dense inputs
+    std::vector<std::tuple<size_t, size_t>> ranges {{0, n - 1}};
+    while (!ranges.empty()) {
+        const auto [start, end] = ranges.back();
+        ranges.pop_back();
+
+        size_t farthest {start};
+        double farthest_deviation {1.0};
+        for (size_t i = start + 1; i < end; i += 1) {
+            const double deviation = relative_deviation(vectors[start], vectors[end], vectors[i]);
+            if (deviation > farthest_deviation) {
+                farthest = i;
+                farthest_deviation = deviation;
+            }
+        }
+
+        if (farthest != start) {
+            is_kept[farthest] = true;
+            ranges.emplace_back(start, farthest);
+            ranges.emplace_back(farthest, end);
+        }
     }
-    init_path_points(converted);
+
+    std::vector<Waypoint> result;
+    for (size_t i = 0; i < n; i += 1) {
+        if (is_kept[i]) {
+            const auto elbow = waypoints[i].elbow ? std::optional<double>(vectors[i](6)) : std::nullopt;
+            result.emplace_back(Affine(vectors[i]), elbow, waypoints[i].blend_max_distance);
+        }
+    }
+    return result;
 }
 
 double Path::get_length() const {
@@ -105,6 +301,15 @@ Vector7d Path::q(double s, const Affine& frame) const {
     return (Affine(init) * frame.inverse()).vector_with_elbow(init(6));
 }
 
+Affine Path::pose(double s) const {
+    auto [segment, s_local] = get_local(s);
+    return segment->pose(s_local);
+}
+
+Affine Path::pose(double s, const Affine& frame) const {
+    return pose(s) * frame.inverse();
+}
+
 Vector7d Path::pdq(double s) const {
     auto [segment, s_local] = get_local(s);
     return segment->pdq(s_local);
@@ -117,7 +322,7 @@ Vector7d Path::pddq(double s) const {
 
 Vector7d Path::pdddq(double s) const {
     auto [segment, s_local] = get_local(s);
-    return segment->pddq(s_local);
+    return segment->pdddq(s_local);
 }
 
 Vector7d Path::dq(double s, double ds) const {
@@ -157,4 +362,52 @@ Vector7d Path::max_pdddq() const {
     return result;
 }
 
+template<class F>
+Eigen::Matrix<double, 7, Eigen::Dynamic> Path::evaluate(const Eigen::VectorXd& s, F f) const {
+    Eigen::Matrix<double, 7, Eigen::Dynamic> result(7, s.size());
+
+    size_t index {0};
+    for (Eigen::Index i = 0; i < s.size(); i += 1) {
+        if (i == 0 || s(i) < s(i - 1)) {
+            index = get_index(s(i));
+        } else {
+            while (index + 1 < segments.size() && cumulative_lengths[index] < s(i)) {
+                index += 1;
+            }
+        }
+
+        const double s_local = (index == 0) ? s(i) : s(i) - cumulative_lengths[index - 1];
+        result.col(i) = f(*segments[index], s_local, i);
+    }
+    return result;
+}
+
+Eigen::Matrix<double, 7, Eigen::Dynamic> Path::q(const Eigen::VectorXd& s) const {
+    return evaluate(s, [](const Segment& segment, double s_local, Eigen::Index) { return segment.q(s_local); });
+}
+
+Eigen::Matrix<double, 7, Eigen::Dynamic> Path::pdq(const Eigen::VectorXd& s) const {
+    return evaluate(s, [](const Segment& segment, double s_local, Eigen::Index) { return segment.pdq(s_local); });
+}
+
+Eigen::Matrix<double, 7, Eigen::Dynamic> Path::pddq(const Eigen::VectorXd& s) const {
+    return evaluate(s, [](const Segment& segment, double s_local, Eigen::Index) { return segment.pddq(s_local); });
+}
+
+Eigen::Matrix<double, 7, Eigen::Dynamic> Path::pdddq(const Eigen::VectorXd& s) const {
+    return evaluate(s, [](const Segment& segment, double s_local, Eigen::Index) { return segment.pdddq(s_local); });
+}
+
+Eigen::Matrix<double, 7, Eigen::Dynamic> Path::dq(const Eigen::VectorXd& s, const Eigen::VectorXd& ds) const {
+    return evaluate(s, [&](const Segment& segment, double s_local, Eigen::Index i) { return segment.dq(s_local, ds(i)); });
+}
+
+Eigen::Matrix<double, 7, Eigen::Dynamic> Path::ddq(const Eigen::VectorXd& s, const Eigen::VectorXd& ds, const Eigen::VectorXd& dds) const {
+    return evaluate(s, [&](const Segment& segment, double s_local, Eigen::Index i) { return segment.ddq(s_local, ds(i), dds(i)); });
+}
+
+Eigen::Matrix<double, 7, Eigen::Dynamic> Path::dddq(const Eigen::VectorXd& s, const Eigen::VectorXd& ds, const Eigen::VectorXd& dds, const Eigen::VectorXd& ddds) const {
+    return evaluate(s, [&](const Segment& segment, double s_local, Eigen::Index i) { return segment.dddq(s_local, ds(i), dds(i), ddds(i)); });
+}
+
 } // namespace movex
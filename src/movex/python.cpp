@@ -1,4 +1,5 @@
 #include <array>
+#include <limits>
 #include <string>
 
 #include <pybind11/pybind11.h>
@@ -9,9 +10,21 @@
 #include <movex/otg/quintic.hpp>
 #include <movex/otg/ruckig.hpp>
 #include <movex/otg/smoothie.hpp>
+#include <movex/path/blend_optimizer.hpp>
+#include <movex/path/collision_check.hpp>
+#include <movex/path/elbow_optimizer.hpp>
+#include <movex/path/joint_limit_check.hpp>
+#include <movex/path/joint_trajectory_conversion.hpp>
+#include <movex/path/parallel_parametrization.hpp>
 #include <movex/path/path.hpp>
+#include <movex/path/redundancy_profile.hpp>
 #include <movex/path/time_parametrization.hpp>
 #include <movex/path/trajectory.hpp>
+#include <movex/path/trajectory_file.hpp>
+#include <movex/robot/batch_kinematics.hpp>
+#include <movex/robot/dynamics.hpp>
+#include <movex/robot/kinematics.hpp>
+#include <movex/robot/reachability_map.hpp>
 
 #ifdef WITH_REFLEXXES
     #include <movex/otg/reflexxes.hpp>
@@ -22,6 +35,8 @@ namespace py = pybind11;
 using namespace pybind11::literals; // to bring in the `_a` literal
 using namespace movex;
 
+using Matrix7Xd = Eigen::Matrix<double, 7, Eigen::Dynamic>;
+
 
 PYBIND11_MODULE(_movex, m) {
     m.doc() = "Robot Motion Library with Focus on Online Trajectory Generation";
@@ -106,19 +121,38 @@ PYBIND11_MODULE(_movex, m) {
         .def("update", &Reflexxes<DOFs>::update);
 #endif
 
-    py::class_<Path>(m, "Path")
-        .def(py::init<const std::vector<Waypoint>&>(), "waypoints"_a)
+    py::class_<Path> path(m, "Path");
+    py::enum_<Path::Interpolation>(path, "Interpolation")
+        .value("Linear", Path::Interpolation::Linear)
+        .value("QuinticSpline", Path::Interpolation::QuinticSpline)
+        .value("Slerp", Path::Interpolation::Slerp)
+        .export_values();
+
+    path.def(py::init<const std::vector<Waypoint>&, Path::Interpolation>(), "waypoints"_a, "interpolation"_a = Path::Interpolation::Linear)
         .def(py::init<const std::vector<Affine>&, double>(), "waypoints"_a, "blend_max_distance"_a = 0.0)
+        .def(py::init<const std::vector<Affine>&, Path::Interpolation>(), "waypoints"_a, "interpolation"_a)
+        .def(py::init<const std::vector<Vector7d>&, double>(), "vectors"_a, "blend_max_distance"_a = 0.0)
         .def_readonly_static("degrees_of_freedom", &Path::degrees_of_freedom)
+        .def_static("simplify", &Path::simplify, "waypoints"_a, "max_translation_deviation"_a, "max_rotation_deviation"_a)
         .def_property_readonly("length", &Path::get_length)
+        .def("append", &Path::append, "waypoints"_a, "blend_max_distance"_a = 0.0, "s_fixed"_a = 0.0)
         .def("q", (Vector7d (Path::*)(double) const)&Path::q, "s"_a)
         .def("q", (Vector7d (Path::*)(double, const Affine&) const)&Path::q, "s"_a, "frame"_a)
-        .def("pdq", &Path::pdq, "s"_a)
-        .def("pddq", &Path::pddq, "s"_a)
-        .def("pdddq", &Path::pdddq, "s"_a)
-        .def("dq", &Path::dq, "s"_a, "ds"_a)
-        .def("ddq", &Path::ddq, "s"_a, "ds"_a, "dds"_a)
-        .def("dddq", &Path::dddq, "s"_a, "ds"_a, "dds"_a, "ddds"_a)
+        .def("pose", (Affine (Path::*)(double) const)&Path::pose, "s"_a)
+        .def("pose", (Affine (Path::*)(double, const Affine&) const)&Path::pose, "s"_a, "frame"_a)
+        .def("pdq", (Vector7d (Path::*)(double) const)&Path::pdq, "s"_a)
+        .def("pddq", (Vector7d (Path::*)(double) const)&Path::pddq, "s"_a)
+        .def("pdddq", (Vector7d (Path::*)(double) const)&Path::pdddq, "s"_a)
+        .def("dq", (Vector7d (Path::*)(double, double) const)&Path::dq, "s"_a, "ds"_a)
+        .def("ddq", (Vector7d (Path::*)(double, double, double) const)&Path::ddq, "s"_a, "ds"_a, "dds"_a)
+        .def("dddq", (Vector7d (Path::*)(double, double, double, double) const)&Path::dddq, "s"_a, "ds"_a, "dds"_a, "ddds"_a)
+        .def("q", (Matrix7Xd (Path::*)(const Eigen::VectorXd&) const)&Path::q, "s"_a)
+        .def("pdq", (Matrix7Xd (Path::*)(const Eigen::VectorXd&) const)&Path::pdq, "s"_a)
+        .def("pddq", (Matrix7Xd (Path::*)(const Eigen::VectorXd&) const)&Path::pddq, "s"_a)
+        .def("pdddq", (Matrix7Xd (Path::*)(const Eigen::VectorXd&) const)&Path::pdddq, "s"_a)
+        .def("dq", (Matrix7Xd (Path::*)(const Eigen::VectorXd&, const Eigen::VectorXd&) const)&Path::dq, "s"_a, "ds"_a)
+        .def("ddq", (Matrix7Xd (Path::*)(const Eigen::VectorXd&, const Eigen::VectorXd&, const Eigen::VectorXd&) const)&Path::ddq, "s"_a, "ds"_a, "dds"_a)
+        .def("dddq", (Matrix7Xd (Path::*)(const Eigen::VectorXd&, const Eigen::VectorXd&, const Eigen::VectorXd&, const Eigen::VectorXd&) const)&Path::dddq, "s"_a, "ds"_a, "dds"_a, "ddds"_a)
         .def("max_pddq", &Path::max_pddq)
         .def("max_pdddq", &Path::max_pdddq);
 
@@ -131,9 +165,202 @@ PYBIND11_MODULE(_movex, m) {
 
     py::class_<Trajectory>(m, "Trajectory")
         .def_readwrite("path", &Trajectory::path)
-        .def_readwrite("states", &Trajectory::states);
+        .def_readwrite("states", &Trajectory::states)
+        .def_property_readonly("states_array", [](const Trajectory& trajectory) {
+            // Copy of the states as rows of (t, s, ds, dds, ddds)
+            using StatesArray = Eigen::Matrix<double, Eigen::Dynamic, 5, Eigen::RowMajor>;
+            return StatesArray(Eigen::Map<const StatesArray>(reinterpret_cast<const double*>(trajectory.states.data()), trajectory.states.size(), 5));
+        })
+        .def("resample", &Trajectory::resample, "delta_time"_a);
+
+    py::class_<TrajectoryFile>(m, "TrajectoryFile")
+        .def_readonly_static("version", &TrajectoryFile::version)
+        .def_static("write", &TrajectoryFile::write, "filename"_a, "trajectory"_a, "delta_time"_a);
+
+    py::class_<MappedTrajectory, std::shared_ptr<MappedTrajectory>>(m, "MappedTrajectory")
+        .def(py::init<const std::string&>(), "filename"_a)
+        .def_readonly("path", &MappedTrajectory::path)
+        .def_readonly("delta_time", &MappedTrajectory::delta_time)
+        .def("__len__", &MappedTrajectory::size)
+        .def("__getitem__", [](const MappedTrajectory& trajectory, size_t index) {
+            if (index >= trajectory.size()) {
+                throw py::index_error();
+            }
+            return trajectory[index];
+        });
+
+    py::class_<Kinematics>(m, "Kinematics")
+        .def(py::init<>())
+        .def(py::init<const Affine&>(), "F_T_EE"_a)
+        .def_readwrite("F_T_EE", &Kinematics::F_T_EE)
+        .def_readonly_static("min_joint_position", &Kinematics::min_joint_position)
+        .def_readonly_static("max_joint_position", &Kinematics::max_joint_position)
+        .def_static("flange", &Kinematics::flange, "q"_a)
+        .def_static("is_within_limits", &Kinematics::is_within_limits, "q"_a)
+        .def("forward", &Kinematics::forward, "q"_a)
+        .def("forward_with_elbow", &Kinematics::forward_with_elbow, "q"_a)
+        .def("jacobian", &Kinematics::jacobian, "q"_a)
+        .def("jacobian_derivative", &Kinematics::jacobian_derivative, "q"_a, "dq"_a)
+        .def_static("manipulability", &Kinematics::manipulability, "jacobian"_a)
+        .def("inverse", (std::vector<Vector7d> (Kinematics::*)(const Affine&, double) const)&Kinematics::inverse, "pose"_a, "q7"_a)
+        .def("inverse", (std::optional<Vector7d> (Kinematics::*)(const Affine&, double, const Vector7d&) const)&Kinematics::inverse, "pose"_a, "q7"_a, "q_current"_a);
+
+    py::class_<Dynamics>(m, "Dynamics")
+        .def(py::init<>())
+        .def(py::init<double, const std::array<double, 3>&, const std::array<double, 9>&>(), "load_mass"_a, "F_x_Cload"_a, "load_inertia"_a)
+        .def_readwrite("gravity_earth", &Dynamics::gravity_earth)
+        .def("set_load", &Dynamics::set_load, "load_mass"_a, "F_x_Cload"_a, "load_inertia"_a)
+        .def("inverse_dynamics", &Dynamics::inverse_dynamics, "q"_a, "dq"_a, "ddq"_a)
+        .def("coriolis", &Dynamics::coriolis, "q"_a, "dq"_a)
+        .def("gravity", &Dynamics::gravity, "q"_a)
+        .def("mass_matrix", &Dynamics::mass_matrix, "q"_a);
+
+    py::class_<ReachabilityMap>(m, "ReachabilityMap")
+        .def(py::init<const std::string&>(), "filename"_a)
+        .def_static("compute", &ReachabilityMap::compute, "kinematics"_a, "resolution"_a = 0.05, "polar_bins"_a = 8, "azimuth_bins"_a = 16, "samples"_a = 10000000, "seed"_a = 42, "number_threads"_a = std::max(std::thread::hardware_concurrency(), 1u), py::call_guard<py::gil_scoped_release>())
+        .def("write", &ReachabilityMap::write, "filename"_a)
+        .def("F_T_EE", &ReachabilityMap::F_T_EE)
+        .def("resolution", &ReachabilityMap::resolution)
+        .def("bin_count", &ReachabilityMap::bin_count)
+        .def("manipulability", (double (ReachabilityMap::*)(const Affine&) const)&ReachabilityMap::manipulability, "pose"_a)
+        .def("manipulability", (Eigen::VectorXd (ReachabilityMap::*)(const Eigen::Matrix<double, 16, Eigen::Dynamic>&) const)&ReachabilityMap::manipulability, "poses"_a)
+        .def("is_reachable", &ReachabilityMap::is_reachable, "pose"_a, "min_manipulability"_a = 0.0);
+
+    py::class_<BatchKinematics>(m, "BatchKinematics")
+        .def(py::init<const Kinematics&, size_t>(), "kinematics"_a = Kinematics(), "number_threads"_a = std::max(std::thread::hardware_concurrency(), 1u))
+        .def_readonly_static("block_size", &BatchKinematics::block_size)
+        .def_readwrite("number_threads", &BatchKinematics::number_threads)
+        .def("forward", &BatchKinematics::forward, "q"_a, py::call_guard<py::gil_scoped_release>())
+        .def("inverse", &BatchKinematics::inverse, "poses"_a, "q7"_a, "q_reference"_a, py::call_guard<py::gil_scoped_release>());
+
+    py::class_<TimeParametrization::Stream>(m, "TimeParametrizationStream")
+        .def("step", &TimeParametrization::Stream::step)
+        .def("is_finished", &TimeParametrization::Stream::is_finished)
+        .def("get_state", &TimeParametrization::Stream::get_state)
+        .def("get_path", &TimeParametrization::Stream::get_path)
+        .def("append", &TimeParametrization::Stream::append, "waypoints"_a, "blend_max_distance"_a = 0.0);
+
+    py::class_<TimeParametrization> time_parametrization(m, "TimeParametrization");
+    py::class_<TimeParametrization::SectionLimit>(time_parametrization, "SectionLimit")
+        .def(py::init([](double s_start, double s_end, double max_ds, double max_dds, double max_ddds) {
+            return TimeParametrization::SectionLimit {s_start, s_end, max_ds, max_dds, max_ddds};
+        }), "s_start"_a, "s_end"_a, "max_ds"_a, "max_dds"_a = std::numeric_limits<double>::infinity(), "max_ddds"_a = std::numeric_limits<double>::infinity())
+        .def_readwrite("s_start", &TimeParametrization::SectionLimit::s_start)
+        .def_readwrite("s_end", &TimeParametrization::SectionLimit::s_end)
+        .def_readwrite("max_ds", &TimeParametrization::SectionLimit::max_ds)
+        .def_readwrite("max_dds", &TimeParametrization::SectionLimit::max_dds)
+        .def_readwrite("max_ddds", &TimeParametrization::SectionLimit::max_ddds);
 
-    py::class_<TimeParametrization>(m, "TimeParametrization")
+    time_parametrization
         .def(py::init<double>(), "delta_time"_a)
+        .def_readwrite("s_resolution", &TimeParametrization::s_resolution)
+        .def_readwrite("lookahead", &TimeParametrization::lookahead)
+        .def_readwrite("max_tool_velocity", &TimeParametrization::max_tool_velocity)
+        .def_readwrite("section_limits", &TimeParametrization::section_limits)
+        .def("stream", &TimeParametrization::stream, "path"_a, "max_velocity"_a, "max_accleration"_a, "max_jerk"_a)
         .def("parametrize", &TimeParametrization::parametrize, "path"_a, "max_velocity"_a, "max_accleration"_a, "max_jerk"_a);
+
+    py::class_<RedundancyProfile>(m, "RedundancyProfile")
+        .def(py::init<double, const std::vector<double>&>(), "s_step"_a, "samples"_a)
+        .def_readonly("s_step", &RedundancyProfile::s_step)
+        .def_readonly("control_points", &RedundancyProfile::control_points)
+        .def("q7", &RedundancyProfile::q7, "s"_a);
+
+    py::class_<ElbowOptimizer>(m, "ElbowOptimizer")
+        .def(py::init<const Kinematics&>(), "kinematics"_a = Kinematics())
+        .def_readwrite("kinematics", &ElbowOptimizer::kinematics)
+        .def_readwrite("s_step", &ElbowOptimizer::s_step)
+        .def_readwrite("s_resolution", &ElbowOptimizer::s_resolution)
+        .def_readwrite("q7_step", &ElbowOptimizer::q7_step)
+        .def_readwrite("max_pdq7", &ElbowOptimizer::max_pdq7)
+        .def_readwrite("max_pddq7", &ElbowOptimizer::max_pddq7)
+        .def_readwrite("limit_weight", &ElbowOptimizer::limit_weight)
+        .def_readwrite("velocity_weight", &ElbowOptimizer::velocity_weight)
+        .def("cost", &ElbowOptimizer::cost, "q"_a)
+        .def("optimize", &ElbowOptimizer::optimize, "path"_a, "frame"_a, "q_start"_a);
+
+    py::class_<JointLimitCheck> joint_limit_check(m, "JointLimitCheck");
+    py::class_<JointLimitCheck::Violation>(joint_limit_check, "Violation")
+        .def_readonly("s_start", &JointLimitCheck::Violation::s_start)
+        .def_readonly("s_end", &JointLimitCheck::Violation::s_end)
+        .def_readonly("velocity_ratio", &JointLimitCheck::Violation::velocity_ratio)
+        .def_readonly("acceleration_ratio", &JointLimitCheck::Violation::acceleration_ratio)
+        .def_readonly("jerk_ratio", &JointLimitCheck::Violation::jerk_ratio)
+        .def_readonly("max_ds", &JointLimitCheck::Violation::max_ds)
+        .def_readonly("max_dds", &JointLimitCheck::Violation::max_dds)
+        .def_readonly("max_ddds", &JointLimitCheck::Violation::max_ddds);
+
+    joint_limit_check
+        .def(py::init<const Kinematics&, const std::array<double, 7>&, const std::array<double, 7>&>(), "kinematics"_a, "max_velocity"_a, "max_acceleration"_a)
+        .def(py::init<const Kinematics&, const std::array<double, 7>&, const std::array<double, 7>&, const std::array<double, 7>&>(), "kinematics"_a, "max_velocity"_a, "max_acceleration"_a, "max_jerk"_a)
+        .def_readwrite("kinematics", &JointLimitCheck::kinematics)
+        .def_readwrite("redundancy", &JointLimitCheck::redundancy)
+        .def_readwrite("margin", &JointLimitCheck::margin)
+        .def_readwrite("section_extension", &JointLimitCheck::section_extension)
+        .def_readwrite("max_iterations", &JointLimitCheck::max_iterations)
+        .def("check", &JointLimitCheck::check, "trajectory"_a, "frame"_a, "q_start"_a)
+        .def("parametrize", &JointLimitCheck::parametrize, "parametrization"_a, "path"_a, "frame"_a, "q_start"_a, "max_velocity"_a, "max_acceleration"_a, "max_jerk"_a);
+
+    py::class_<JointTrajectoryConversion>(m, "JointTrajectoryConversion")
+        .def(py::init<const Kinematics&, const std::array<double, 7>&, const std::array<double, 7>&, const std::array<double, 7>&>(), "kinematics"_a, "max_velocity"_a, "max_acceleration"_a, "max_jerk"_a)
+        .def_readwrite("kinematics", &JointTrajectoryConversion::kinematics)
+        .def_readwrite("redundancy", &JointTrajectoryConversion::redundancy)
+        .def_readwrite("start_tolerance", &JointTrajectoryConversion::start_tolerance)
+        .def("convert", &JointTrajectoryConversion::convert, "trajectory"_a, "frame"_a, "q_start"_a);
+
+    py::class_<CollisionCheck> collision_check(m, "CollisionCheck");
+    py::class_<CollisionCheck::Capsule>(collision_check, "Capsule")
+        .def(py::init<const Eigen::Vector3d&, const Eigen::Vector3d&, double>(), "start"_a, "end"_a, "radius"_a)
+        .def_readwrite("start", &CollisionCheck::Capsule::start)
+        .def_readwrite("end", &CollisionCheck::Capsule::end)
+        .def_readwrite("radius", &CollisionCheck::Capsule::radius);
+
+    py::class_<CollisionCheck::LinkCapsule>(collision_check, "LinkCapsule")
+        .def(py::init<size_t, const CollisionCheck::Capsule&>(), "frame"_a, "capsule"_a)
+        .def_readwrite("frame", &CollisionCheck::LinkCapsule::frame)
+        .def_readwrite("capsule", &CollisionCheck::LinkCapsule::capsule);
+
+    py::class_<CollisionCheck::Contact>(collision_check, "Contact")
+        .def_readonly("t", &CollisionCheck::Contact::t)
+        .def_readonly("s", &CollisionCheck::Contact::s)
+        .def_readonly("distance", &CollisionCheck::Contact::distance);
+
+    collision_check
+        .def(py::init<const Kinematics&>(), "kinematics"_a = Kinematics())
+        .def_readwrite("kinematics", &CollisionCheck::kinematics)
+        .def_readwrite("link_capsules", &CollisionCheck::link_capsules)
+        .def_readwrite("min_distance", &CollisionCheck::min_distance)
+        .def_readwrite("s_step", &CollisionCheck::s_step)
+        .def_readwrite("s_resolution", &CollisionCheck::s_resolution)
+        .def_readwrite("redundancy", &CollisionCheck::redundancy)
+        .def_static("panda_capsules", &CollisionCheck::panda_capsules)
+        .def("add_plane", &CollisionCheck::add_plane, "normal"_a, "offset"_a)
+        .def("add_box", &CollisionCheck::add_box, "pose"_a, "size"_a)
+        .def("add_capsule", &CollisionCheck::add_capsule, "start"_a, "end"_a, "radius"_a)
+        .def("add_sphere", &CollisionCheck::add_sphere, "center"_a, "radius"_a)
+        .def("clear_obstacles", &CollisionCheck::clear_obstacles)
+        .def("distance", &CollisionCheck::distance, "q"_a)
+        .def("is_colliding", &CollisionCheck::is_colliding, "q"_a)
+        .def("check", &CollisionCheck::check, "trajectory"_a, "frame"_a, "q_start"_a);
+
+    py::class_<ParallelParametrization> parallel_parametrization(m, "ParallelParametrization");
+    py::class_<ParallelParametrization::Candidate>(parallel_parametrization, "Candidate")
+        .def(py::init<const std::vector<Waypoint>&, Path::Interpolation, const std::array<double, 7>&, const std::array<double, 7>&, const std::array<double, 7>&>(), "waypoints"_a, "interpolation"_a, "max_velocity"_a, "max_acceleration"_a, "max_jerk"_a)
+        .def_readwrite("waypoints", &ParallelParametrization::Candidate::waypoints)
+        .def_readwrite("interpolation", &ParallelParametrization::Candidate::interpolation);
+
+    py::class_<ParallelParametrization::Result>(parallel_parametrization, "Result")
+        .def_readonly("index", &ParallelParametrization::Result::index)
+        .def_readonly("trajectory", &ParallelParametrization::Result::trajectory);
+
+    parallel_parametrization.def(py::init<double, size_t>(), "delta_time"_a, "number_threads"_a = std::max(std::thread::hardware_concurrency(), 1u))
+        .def_readwrite("number_threads", &ParallelParametrization::number_threads)
+        .def("fastest", &ParallelParametrization::fastest, "candidates"_a, py::call_guard<py::gil_scoped_release>());
+
+    py::class_<BlendOptimizer>(m, "BlendOptimizer")
+        .def(py::init<const std::array<double, 7>&, const std::array<double, 7>&, const std::array<double, 7>&>(), "max_velocity"_a, "max_acceleration"_a, "max_jerk"_a)
+        .def_readwrite("number_candidates", &BlendOptimizer::number_candidates)
+        .def_readwrite("number_iterations", &BlendOptimizer::number_iterations)
+        .def("predict_duration", &BlendOptimizer::predict_duration, "path"_a)
+        .def("optimize", &BlendOptimizer::optimize, "waypoints"_a, "tolerance"_a);
 }
@@ -0,0 +1,129 @@
+#include <movex/robot/reachability_map.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+
+namespace movex {
+
+ReachabilityMap ReachabilityMap::compute(const Kinematics& kinematics, double resolution, size_t polar_bins, size_t azimuth_bins, size_t samples, uint64_t seed, size_t number_threads) {
+    if (resolution <= 0.0 || polar_bins == 0 || azimuth_bins == 0) {
+        throw std::runtime_error("Reachability map needs a positive resolution and number of direction bins.");
+    }
+
+    ReachabilityMap map;
+    map.header.magic = magic;
+    map.header.version = version;
+    map.header.byte_order = byte_order;
+    map.header.F_T_EE = kinematics.F_T_EE.array();
+    map.header.resolution = resolution;
+    map.header.polar_bins = polar_bins;
+    map.header.azimuth_bins = azimuth_bins;
+    map.header.bins_offset = (sizeof(Header) + bins_alignment - 1) / bins_alignment * bins_alignment;
+
+    // Bounding cube of the workspace around the shoulder, from the lengths of all links and the end effector
+    double reach {kinematics.F_T_EE.translation().norm()};
+    for (size_t i = 1; i < Kinematics::dh_parameters.size(); i += 1) {
+        reach += std::hypot(Kinematics::dh_parameters[i][0], Kinematics::dh_parameters[i][1]);
+    }
+    const Eigen::Vector3d shoulder {0.0, 0.0, Kinematics::dh_parameters[0][1]};
+    for (size_t i = 0; i < 3; i += 1) {
+        map.header.size[i] = std::ceil(2 * reach / resolution);
+        map.header.origin[i] = shoulder(i) - map.header.size[i] * resolution / 2;
+    }
+
+    // Each thread records the best manipulability per bin of its own samples
+    const size_t threads = std::max<size_t>(std::min(number_threads, samples), 1);
+    std::vector<std::vector<float>> best(threads);
+    auto sample = [&](size_t thread) {
+        auto& values = best[thread];
+        values.assign(map.bin_count(), 0.0f);
+
+        std::mt19937_64 gen(seed + thread);
+        std::array<std::uniform_real_distribution<double>, 7> distributions;
+        for (size_t j = 0; j < 7; j += 1) {
+            distributions[j] = std::uniform_real_distribution<double>(Kinematics::min_joint_position[j], Kinematics::max_joint_position[j]);
+        }
+
+        Vector7d q;
+        for (size_t k = thread; k < samples; k += threads) {
+            for (size_t j = 0; j < 7; j += 1) {
+                q(j) = distributions[j](gen);
+            }
+
+            const size_t i = map.index(kinematics.forward(q));
+            if (i < values.size()) {
+                // Zero would be unreachable
+                const float manipulability = std::max<float>(Kinematics::manipulability(kinematics.jacobian(q)), std::numeric_limits<float>::min());
+                values[i] = std::max(values[i], manipulability);
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t thread = 1; thread < threads; thread += 1) {
+        workers.emplace_back(sample, thread);
+    }
+    sample(0);
+    for (auto& worker: workers) {
+        worker.join();
+    }
+
+    for (size_t thread = 1; thread < threads; thread += 1) {
+        for (size_t i = 0; i < best[0].size(); i += 1) {
+            best[0][i] = std::max(best[0][i], best[thread][i]);
+        }
+    }
+
+    // Quantize with rounding up, so that every reached bin stays non-zero
+    const auto& values = best[0];
+    map.header.max_manipulability = *std::max_element(values.begin(), values.end());
+    map.computed_bins.resize(values.size());
+    for (size_t i = 0; i < values.size(); i += 1) {
+        map.computed_bins[i] = (map.header.max_manipulability > 0.0) ? std::ceil(255 * values[i] / map.header.max_manipulability) : 0;
+    }
+    return map;
+}
+
+
+ReachabilityMap::ReachabilityMap(const std::string& filename): mapping(std::make_shared<FileMapping>(filename)) {
+    if (mapping->size < sizeof(Header)) {
+        throw std::runtime_error("Reachability map file " + filename + " ends within its header.");
+    }
+    std::memcpy(&header, mapping->data, sizeof(Header));
+
+    if (header.magic != magic) {
+        throw std::runtime_error("File is not a reachability map file.");
+    }
+    if (header.version != version) {
+        throw std::runtime_error("Reachability map file has version " + std::to_string(header.version) + ", but only version " + std::to_string(version) + " is supported.");
+    }
+    if (header.byte_order != byte_order) {
+        throw std::runtime_error("Reachability map file was written with a different byte order.");
+    }
+    if (header.resolution <= 0.0 || header.polar_bins == 0 || header.azimuth_bins == 0 || header.bins_offset < sizeof(Header) || header.bins_offset + bin_count() > mapping->size) {
+        throw std::runtime_error("Reachability map file has an invalid grid or bins section.");
+    }
+}
+
+
+void ReachabilityMap::write(const std::string& filename) const {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Could not open reachability map file " + filename + " for writing.");
+    }
+
+    const std::vector<char> padding(header.bins_offset - sizeof(Header), 0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    file.write(padding.data(), padding.size());
+    file.write(reinterpret_cast<const char*>(bins()), bin_count());
+
+    if (!file) {
+        throw std::runtime_error("Could not write reachability map file " + filename + ".");
+    }
+}
+
+} // namespace movex
@@ -0,0 +1,196 @@
+#include <movex/path/trajectory_file.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+
+namespace movex {
+
+static_assert(std::is_standard_layout<Trajectory::State>::value && sizeof(Trajectory::State) == 5 * sizeof(double), "Trajectory states need to be stored as plain doubles.");
+
+namespace {
+
+void append_values(std::vector<double>& values, const Vector7d& vector) {
+    values.insert(values.end(), vector.data(), vector.data() + vector.size());
+}
+
+template<class T>
+T read_value(const char* data, size_t size, size_t& offset) {
+    if (offset + sizeof(T) > size) {
+        throw std::runtime_error("Trajectory file ends unexpectedly at byte " + std::to_string(offset) + ".");
+    }
+
+    T value;
+    std::memcpy(&value, data + offset, sizeof(T));
+    offset += sizeof(T);
+    return value;
+}
+
+} // namespace
+
+
+void TrajectoryFile::write(const std::string& filename, const Trajectory& trajectory, double delta_time) {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Could not open trajectory file " + filename + " for writing.");
+    }
+
+    auto write_bytes = [&](const void* bytes, size_t size) {
+        file.write(static_cast<const char*>(bytes), size);
+    };
+
+    // Segments as (type, value count, values) records
+    std::vector<char> segment_data;
+    for (const auto& segment: trajectory.path.segments) {
+        SegmentType type;
+        std::vector<double> values;
+        if (const auto line = std::dynamic_pointer_cast<LineSegment>(segment)) {
+            type = SegmentType::Line;
+            append_values(values, line->start);
+            append_values(values, line->end);
+
+        } else if (const auto blend = std::dynamic_pointer_cast<QuarticBlendSegment>(segment)) {
+            type = SegmentType::QuarticBlend;
+            values.push_back(blend->s_length);
+            for (const auto& vector: {blend->b, blend->c, blend->e, blend->f, blend->lb, blend->lm, blend->rb, blend->rm}) {
+                append_values(values, vector);
+            }
+
+        } else if (const auto quintic = std::dynamic_pointer_cast<QuinticSegment>(segment)) {
+            type = SegmentType::Quintic;
+            values.push_back(quintic->length);
+            for (const auto& vector: {quintic->c0, quintic->c1, quintic->c2, quintic->c3, quintic->c4, quintic->c5}) {
+                append_values(values, vector);
+            }
+
+        } else if (const auto slerp = std::dynamic_pointer_cast<SlerpSegment>(segment)) {
+            type = SegmentType::Slerp;
+            for (const auto& [translation, rotation, elbow]: {std::make_tuple(slerp->start_translation, slerp->start_rotation, slerp->start_elbow), std::make_tuple(slerp->end_translation, slerp->end_rotation, slerp->end_elbow)}) {
+                values.insert(values.end(), translation.data(), translation.data() + 3);
+                values.insert(values.end(), {rotation.w(), rotation.x(), rotation.y(), rotation.z(), elbow});
+            }
+
+        } else {
+            throw std::runtime_error("Trajectory file does not support the segment type of the path.");
+        }
+
+        const uint64_t value_count = values.size();
+        const size_t offset = segment_data.size();
+        segment_data.resize(offset + sizeof(type) + sizeof(value_count) + value_count * sizeof(double));
+        std::memcpy(segment_data.data() + offset, &type, sizeof(type));
+        std::memcpy(segment_data.data() + offset + sizeof(type), &value_count, sizeof(value_count));
+        std::memcpy(segment_data.data() + offset + sizeof(type) + sizeof(value_count), values.data(), value_count * sizeof(double));
+    }
+
+    const uint64_t segments_end = sizeof(Header) + segment_data.size();
+
+    Header header;
+    header.magic = magic;
+    header.version = version;
+    header.byte_order = byte_order;
+    header.delta_time = delta_time;
+    header.segment_count = trajectory.path.segments.size();
+    header.state_count = trajectory.states.size();
+    header.states_offset = (segments_end + states_alignment - 1) / states_alignment * states_alignment;
+
+    const std::vector<char> padding(header.states_offset - segments_end, 0);
+
+    write_bytes(&header, sizeof(header));
+    write_bytes(segment_data.data(), segment_data.size());
+    write_bytes(padding.data(), padding.size());
+    write_bytes(trajectory.states.data(), trajectory.states.size() * sizeof(Trajectory::State));
+
+    if (!file) {
+        throw std::runtime_error("Could not write trajectory file " + filename + ".");
+    }
+}
+
+
+Path MappedTrajectory::read_path(const FileMapping& mapping) {
+    size_t offset {0};
+    const auto header = read_value<TrajectoryFile::Header>(mapping.data, mapping.size, offset);
+    if (header.magic != TrajectoryFile::magic) {
+        throw std::runtime_error("File is not a trajectory file.");
+    }
+    if (header.version != TrajectoryFile::version) {
+        throw std::runtime_error("Trajectory file has version " + std::to_string(header.version) + ", but only version " + std::to_string(TrajectoryFile::version) + " is supported.");
+    }
+    if (header.byte_order != TrajectoryFile::byte_order) {
+        throw std::runtime_error("Trajectory file was written with a different byte order.");
+    }
+
+    auto read_vector = [&]() {
+        Vector7d vector;
+        for (size_t i = 0; i < 7; i += 1) {
+            vector(i) = read_value<double>(mapping.data, mapping.size, offset);
+        }
+        return vector;
+    };
+
+    std::vector<std::shared_ptr<Segment>> segments;
+    segments.reserve(header.segment_count);
+    for (size_t i = 0; i < header.segment_count; i += 1) {
+        const auto type = read_value<TrajectoryFile::SegmentType>(mapping.data, mapping.size, offset);
+        const auto value_count = read_value<uint64_t>(mapping.data, mapping.size, offset);
+        const size_t values_end = offset + value_count * sizeof(double);
+
+        switch (type) {
+            case TrajectoryFile::SegmentType::Line: {
+                const Vector7d start = read_vector();
+                const Vector7d end = read_vector();
+                segments.emplace_back(std::make_shared<LineSegment>(start, end));
+            } break;
+            case TrajectoryFile::SegmentType::QuarticBlend: {
+                const double s_length = read_value<double>(mapping.data, mapping.size, offset);
+                const Vector7d b = read_vector(), c = read_vector(), e = read_vector(), f = read_vector();
+                const Vector7d lb = read_vector(), lm = read_vector(), rb = read_vector(), rm = read_vector();
+                segments.emplace_back(std::make_shared<QuarticBlendSegment>(s_length, b, c, e, f, lb, lm, rb, rm));
+            } break;
+            case TrajectoryFile::SegmentType::Quintic: {
+                const double length = read_value<double>(mapping.data, mapping.size, offset);
+                std::array<Vector7d, 6> coefficients;
+                for (auto& coefficient: coefficients) {
+                    coefficient = read_vector();
+                }
+                segments.emplace_back(std::make_shared<QuinticSegment>(coefficients, length));
+            } break;
+            case TrajectoryFile::SegmentType::Slerp: {
+                std::array<std::tuple<Eigen::Vector3d, Eigen::Quaterniond, double>, 2> ends;
+                for (auto& [translation, rotation, elbow]: ends) {
+                    for (size_t j = 0; j < 3; j += 1) {
+                        translation(j) = read_value<double>(mapping.data, mapping.size, offset);
+                    }
+                    for (size_t j = 0; j < 4; j += 1) {
+                        rotation.coeffs()((j + 3) % 4) = read_value<double>(mapping.data, mapping.size, offset); // Eigen stores (x, y, z, w)
+                    }
+                    elbow = read_value<double>(mapping.data, mapping.size, offset);
+                }
+                segments.emplace_back(std::make_shared<SlerpSegment>(std::get<0>(ends[0]), std::get<1>(ends[0]), std::get<2>(ends[0]), std::get<0>(ends[1]), std::get<1>(ends[1]), std::get<2>(ends[1])));
+            } break;
+            default: {
+                throw std::runtime_error("Trajectory file contains unknown segment type " + std::to_string(static_cast<uint64_t>(type)) + ".");
+            }
+        }
+
+        if (offset != values_end) {
+            throw std::runtime_error("Trajectory file contains a segment with an invalid number of values.");
+        }
+    }
+
+    if (header.states_offset < offset || header.states_offset % alignof(Trajectory::State) != 0 || header.states_offset + header.state_count * sizeof(Trajectory::State) > mapping.size) {
+        throw std::runtime_error("Trajectory file has an invalid states section.");
+    }
+    return Path(segments);
+}
+
+MappedTrajectory::MappedTrajectory(const std::string& filename): mapping(filename), path(read_path(mapping)) {
+    TrajectoryFile::Header header;
+    std::memcpy(&header, mapping.data, sizeof(header));
+
+    delta_time = header.delta_time;
+    states = reinterpret_cast<const Trajectory::State*>(mapping.data + header.states_offset);
+    state_count = header.state_count;
+}
+
+} // namespace movex
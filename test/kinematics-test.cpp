@@ -0,0 +1,351 @@
+#define CATCH_CONFIG_MAIN
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+
+#include <catch2/catch.hpp>
+#include <Eigen/Core>
+#include <Eigen/Cholesky>
+
+#include <movex/robot/batch_kinematics.hpp>
+#include <movex/robot/dynamics.hpp>
+#include <movex/robot/kinematics.hpp>
+#include <movex/robot/reachability_map.hpp>
+
+
+using namespace movex;
+
+
+//! File in the temporary directory that is removed at the end of the scope, also if a test case throws
+struct TemporaryFile {
+    std::string filename;
+
+    explicit TemporaryFile(const std::string& name): filename((std::filesystem::temp_directory_path() / (std::to_string(std::random_device()()) + "-" + name)).string()) { }
+
+    ~TemporaryFile() {
+        std::remove(filename.c_str());
+    }
+};
+
+
+TEST_CASE("Forward kinematics") {
+    Kinematics kinematics;
+
+    SECTION("Known poses") {
+        // Flange at the zero configuration
+        const auto flange = Kinematics::flange(Vector7d::Zero());
+        CHECK( flange.x() == Approx(0.088) );
+        CHECK( flange.y() == Approx(0.0).margin(1e-12) );
+        CHECK( flange.z() == Approx(0.926) );
+
+        // Default home configuration with the Franka Hand pointing down
+        const Vector7d q_home = (Vector7d() << 0.0, -M_PI / 4, 0.0, -3 * M_PI / 4, 0.0, M_PI / 2, M_PI / 4).finished();
+        const auto [pose, elbow] = kinematics.forward_with_elbow(q_home);
+        CHECK( pose.x() == Approx(0.30689).margin(1e-5) );
+        CHECK( pose.y() == Approx(0.0).margin(1e-12) );
+        CHECK( pose.z() == Approx(0.48688).margin(1e-5) );
+        CHECK( (pose.rotation() - Eigen::Vector3d(1.0, -1.0, -1.0).asDiagonal().toDenseMatrix()).norm() < 1e-12 );
+        CHECK( elbow == 0.0 );
+        CHECK( Kinematics::is_within_limits(q_home) );
+        CHECK_FALSE( Kinematics::is_within_limits(Vector7d::Zero()) );
+    }
+
+    SECTION("End effector and joint frames") {
+        std::default_random_engine gen(41);
+        std::uniform_real_distribution<double> dist(-2.0, 2.0);
+
+        const auto F_T_EE = Affine(0.01, 0.02, 0.2, 0.3, 0.0, 0.0);
+        const Kinematics kinematics_tool {F_T_EE};
+
+        for (size_t i = 0; i < 100; i += 1) {
+            Vector7d q;
+            for (size_t j = 0; j < 7; j += 1) {
+                q(j) = dist(gen);
+            }
+
+            const auto frames = Kinematics::joint_frames(q);
+            CHECK( Affine(Affine::Type(frames[7])).isApprox(Kinematics::flange(q)) );
+            CHECK( kinematics_tool.forward(q).isApprox(Kinematics::flange(q) * F_T_EE) );
+
+            // The rotation of the first joint turns the whole robot around the z-axis
+            Vector7d q_turned = q;
+            q_turned(0) += 0.5;
+            const auto pose = kinematics.forward(q), pose_turned = kinematics.forward(q_turned);
+            CHECK( pose_turned.z() == Approx(pose.z()) );
+            CHECK( pose_turned.translation().head<2>().norm() == Approx(pose.translation().head<2>().norm()) );
+        }
+    }
+}
+
+
+TEST_CASE("Inverse kinematics") {
+    Kinematics kinematics {Affine(0.0, 0.0, 0.15, 0.2, 0.0, 0.0)};
+
+    std::default_random_engine gen(42);
+    auto random_configuration = [&]() {
+        Vector7d q;
+        for (size_t j = 0; j < 7; j += 1) {
+            std::uniform_real_distribution<double> dist(Kinematics::min_joint_position[j], Kinematics::max_joint_position[j]);
+            q(j) = dist(gen);
+        }
+        return q;
+    };
+
+    bool all_reached {true}, all_found {true}, all_closest {true};
+    for (size_t i = 0; i < 1000; i += 1) {
+        const Vector7d q = random_configuration();
+        const auto pose = kinematics.forward(q);
+
+        // Every solution reaches the pose, and one of them is the original configuration
+        const auto solutions = kinematics.inverse(pose, q(6));
+        bool found {false};
+        for (const auto& solution: solutions) {
+            all_reached &= Kinematics::is_within_limits(solution) && kinematics.forward(solution).isApprox(pose);
+            found |= (solution - q).norm() < 1e-6;
+        }
+        all_found &= found;
+
+        const auto closest = kinematics.inverse(pose, q(6), q);
+        all_closest &= closest && (*closest - q).norm() < 1e-6;
+    }
+    CHECK( all_reached );
+    CHECK( all_found );
+    CHECK( all_closest );
+
+    // Out of reach
+    CHECK( kinematics.inverse(Affine(1.5, 0.0, 0.5), 0.0).empty() );
+    CHECK_FALSE( kinematics.inverse(Affine(1.5, 0.0, 0.5), 0.0, Vector7d::Zero()) );
+}
+
+
+TEST_CASE("Batch kinematics") {
+    const Kinematics kinematics {Affine(0.0, 0.0, 0.1034, -M_PI / 4, 0.0, 0.0)};
+    const BatchKinematics batch {kinematics, 3};
+
+    // Not a multiple of the block size
+    const size_t n = 1001;
+    std::default_random_engine gen(43);
+    Eigen::Matrix<double, 7, Eigen::Dynamic> q(7, n);
+    for (size_t j = 0; j < 7; j += 1) {
+        std::uniform_real_distribution<double> dist(Kinematics::min_joint_position[j], Kinematics::max_joint_position[j]);
+        for (size_t i = 0; i < n; i += 1) {
+            q(j, i) = dist(gen);
+        }
+    }
+
+    const auto poses = batch.forward(q);
+    REQUIRE( poses.cols() == n );
+
+    double max_difference {0.0};
+    for (size_t i = 0; i < n; i += 1) {
+        const auto pose = kinematics.forward(q.col(i));
+        max_difference = std::max(max_difference, (Eigen::Matrix4d::Map(poses.col(i).data()) - pose.data.matrix()).cwiseAbs().maxCoeff());
+    }
+    CHECK( max_difference < 1e-12 );
+
+    // Reaches the original configurations, and marks unreachable poses with NaN
+    Eigen::Matrix<double, 16, Eigen::Dynamic> targets = poses;
+    targets(12, 0) += 2.0;
+    const auto q_inverse = batch.inverse(targets, q.row(6).transpose(), q);
+    CHECK( q_inverse.col(0).array().isNaN().all() );
+    CHECK( (q_inverse.rightCols(n - 1) - q.rightCols(n - 1)).cwiseAbs().maxCoeff() < 1e-6 );
+
+    CHECK_THROWS( batch.inverse(targets, Eigen::VectorXd::Zero(2), q) );
+
+    // Independent of the number of threads
+    CHECK( BatchKinematics(kinematics, 1).forward(q) == poses );
+}
+
+
+TEST_CASE("Jacobian") {
+    const Kinematics kinematics {Affine(0.01, 0.02, 0.15, 0.2, 0.0, 0.0)};
+
+    std::default_random_engine gen(44);
+    std::uniform_real_distribution<double> dist(-2.0, 2.0);
+
+    const double h {1e-6};
+    double max_jacobian_error {0.0}, max_derivative_error {0.0};
+    for (size_t i = 0; i < 100; i += 1) {
+        Vector7d q, dq;
+        for (size_t j = 0; j < 7; j += 1) {
+            q(j) = dist(gen);
+            dq(j) = dist(gen);
+        }
+
+        // Translational and angular velocity from the central difference of the forward kinematics
+        const auto pose_before = kinematics.forward(q - h * dq), pose_after = kinematics.forward(q + h * dq);
+        const Eigen::Matrix3d dR = (pose_after.rotation() - pose_before.rotation()) / (2 * h);
+        const Eigen::Matrix3d omega_skew = dR * kinematics.forward(q).rotation().transpose();
+
+        Eigen::Matrix<double, 6, 1> velocity;
+        velocity << (pose_after.translation() - pose_before.translation()) / (2 * h), omega_skew(2, 1), omega_skew(0, 2), omega_skew(1, 0);
+
+        const auto J = kinematics.jacobian(q);
+        max_jacobian_error = std::max(max_jacobian_error, (J * dq - velocity).cwiseAbs().maxCoeff());
+
+        const Eigen::Matrix<double, 6, 7> dJ = (kinematics.jacobian(q + h * dq) - kinematics.jacobian(q - h * dq)) / (2 * h);
+        max_derivative_error = std::max(max_derivative_error, (kinematics.jacobian_derivative(q, dq) - dJ).cwiseAbs().maxCoeff());
+    }
+    CHECK( max_jacobian_error < 1e-6 );
+    CHECK( max_derivative_error < 1e-6 );
+
+    // The stretched arm is singular
+    const Vector7d q_home = (Vector7d() << 0.0, -M_PI / 4, 0.0, -3 * M_PI / 4, 0.0, M_PI / 2, M_PI / 4).finished();
+    CHECK( Kinematics::manipulability(kinematics.jacobian(Vector7d::Zero())) == Approx(0.0).margin(1e-9) );
+    CHECK( Kinematics::manipulability(kinematics.jacobian(q_home)) > 0.01 );
+}
+
+
+TEST_CASE("Dynamics") {
+    const Dynamics dynamics;
+
+    std::default_random_engine gen(45);
+    std::uniform_real_distribution<double> dist(-2.0, 2.0);
+    auto random_vector = [&]() {
+        Vector7d v;
+        for (size_t j = 0; j < 7; j += 1) {
+            v(j) = dist(gen);
+        }
+        return v;
+    };
+
+    SECTION("Consistency of Newton-Euler and mass matrix") {
+        const double h {1e-6};
+        for (size_t i = 0; i < 100; i += 1) {
+            const Vector7d q = random_vector(), dq = random_vector(), ddq = random_vector();
+
+            const auto M = dynamics.mass_matrix(q);
+            CHECK( (M - M.transpose()).cwiseAbs().maxCoeff() == 0.0 );
+            CHECK( M.llt().info() == Eigen::Success );
+
+            const Vector7d tau = M * ddq + dynamics.coriolis(q, dq) + dynamics.gravity(q);
+            CHECK( (dynamics.inverse_dynamics(q, dq, ddq) - tau).cwiseAbs().maxCoeff() < 1e-10 );
+
+            // Skew-symmetry of dM - 2C: dq^T C dq = 1/2 dq^T dM dq
+            const Eigen::Matrix<double, 7, 7> dM = (dynamics.mass_matrix(q + h * dq) - dynamics.mass_matrix(q - h * dq)) / (2 * h);
+            CHECK( dq.dot(dynamics.coriolis(q, dq)) == Approx(0.5 * dq.dot(dM * dq)).epsilon(1e-6).margin(1e-6) );
+
+            // The first joint is vertical
+            CHECK( dynamics.gravity(q)(0) == Approx(0.0).margin(1e-12) );
+        }
+    }
+
+    SECTION("Reference torques from the Lagrangian of the identified links") {
+        // Mass matrix and gravity from the Jacobians of each center of mass, independent of the recursive algorithms
+        auto lagrangian = [](const Vector7d& q, const Eigen::Vector3d& gravity_earth) {
+            const auto frames = Kinematics::joint_frames(q);
+            Eigen::Matrix<double, 7, 7> M = Eigen::Matrix<double, 7, 7>::Zero();
+            Vector7d gravity = Vector7d::Zero();
+            for (size_t k = 0; k < 7; k += 1) {
+                const auto& c = Dynamics::link_coms[k];
+                const auto& I = Dynamics::link_inertias[k];
+                const Eigen::Matrix3d R = frames[k].block<3, 3>(0, 0);
+                const Eigen::Vector3d com = (frames[k] * Eigen::Vector4d(c[0], c[1], c[2], 1.0)).head<3>();
+                Eigen::Matrix3d inertia;
+                inertia << I[0], I[1], I[2], I[1], I[3], I[4], I[2], I[4], I[5];
+
+                Eigen::Matrix<double, 3, 7> Jv = Eigen::Matrix<double, 3, 7>::Zero(), Jw = Eigen::Matrix<double, 3, 7>::Zero();
+                for (size_t j = 0; j <= k; j += 1) {
+                    const Eigen::Vector3d z = frames[j].block<3, 1>(0, 2);
+                    Jv.col(j) = z.cross(com - frames[j].block<3, 1>(0, 3));
+                    Jw.col(j) = z;
+                }
+
+                const double mass = Dynamics::link_masses[k];
+                M += mass * Jv.transpose() * Jv + Jw.transpose() * R * inertia * R.transpose() * Jw;
+                gravity -= mass * Jv.transpose() * gravity_earth;
+            }
+            return std::make_tuple(M, gravity);
+        };
+
+        // Coriolis torques of the Lagrangian: dM/dt dq - 1/2 d(dq^T M dq)/dq, with central differences
+        const double h {1e-5};
+        for (size_t i = 0; i < 20; i += 1) {
+            const Vector7d q = random_vector(), dq = random_vector();
+            const auto [M, gravity] = lagrangian(q, dynamics.gravity_earth);
+
+            const Eigen::Matrix<double, 7, 7> dM = (std::get<0>(lagrangian(q + h * dq, dynamics.gravity_earth)) - std::get<0>(lagrangian(q - h * dq, dynamics.gravity_earth))) / (2 * h);
+            Vector7d coriolis = dM * dq;
+            for (size_t j = 0; j < 7; j += 1) {
+                const Vector7d e = h * Vector7d::Unit(j);
+                const double energy_plus = dq.dot(std::get<0>(lagrangian(q + e, dynamics.gravity_earth)) * dq);
+                const double energy_minus = dq.dot(std::get<0>(lagrangian(q - e, dynamics.gravity_earth)) * dq);
+                coriolis(j) -= 0.5 * (energy_plus - energy_minus) / (2 * h);
+            }
+
+            CHECK( (dynamics.mass_matrix(q) - M).cwiseAbs().maxCoeff() < 1e-10 );
+            CHECK( (dynamics.gravity(q) - gravity).cwiseAbs().maxCoeff() < 1e-10 );
+            CHECK( (dynamics.coriolis(q, dq) - coriolis).cwiseAbs().maxCoeff() < 1e-6 );
+        }
+    }
+
+    SECTION("Load") {
+        const std::array<double, 3> F_x_Cload {{0.01, -0.02, 0.05}};
+        const std::array<double, 9> load_inertia {{0.002, 0.0001, 0.0, 0.0001, 0.003, 0.0, 0.0, 0.0, 0.001}};
+        const double load_mass {1.5};
+
+        Dynamics dynamics_load;
+        dynamics_load.set_load(load_mass, F_x_Cload, load_inertia);
+
+        // The load adds a rigid body at its center of mass, seen through the Jacobian of that point
+        const Kinematics kinematics {Affine(F_x_Cload[0], F_x_Cload[1], F_x_Cload[2])};
+        for (size_t i = 0; i < 100; i += 1) {
+            const Vector7d q = random_vector();
+            const auto J = kinematics.jacobian(q);
+            const Eigen::Matrix3d R = kinematics.forward(q).rotation();
+            const Eigen::Matrix3d I = R * Eigen::Matrix3d(load_inertia.data()) * R.transpose();
+
+            const Vector7d gravity = -load_mass * J.topRows<3>().transpose() * dynamics.gravity_earth;
+            CHECK( (dynamics_load.gravity(q) - dynamics.gravity(q) - gravity).cwiseAbs().maxCoeff() < 1e-10 );
+
+            const Eigen::Matrix<double, 7, 7> M = load_mass * J.topRows<3>().transpose() * J.topRows<3>() + J.bottomRows<3>().transpose() * I * J.bottomRows<3>();
+            CHECK( (dynamics_load.mass_matrix(q) - dynamics.mass_matrix(q) - M).cwiseAbs().maxCoeff() < 1e-10 );
+        }
+    }
+}
+
+
+TEST_CASE("Reachability map") {
+    const Kinematics kinematics;
+    const auto map = ReachabilityMap::compute(kinematics, 0.1, 4, 8, 1000000, 42, 2);
+
+    // Nearly all poses of random joint positions fall into a sampled bin
+    std::default_random_engine gen(47);
+    std::vector<Affine> poses;
+    size_t reached {0};
+    for (size_t i = 0; i < 1000; i += 1) {
+        Vector7d q;
+        for (size_t j = 0; j < 7; j += 1) {
+            std::uniform_real_distribution<double> dist(Kinematics::min_joint_position[j], Kinematics::max_joint_position[j]);
+            q(j) = dist(gen);
+        }
+        poses.push_back(kinematics.forward(q));
+        reached += map.is_reachable(poses.back());
+    }
+    CHECK( reached > 990 );
+
+    // Outside of the workspace and pointing into the base
+    CHECK_FALSE( map.is_reachable(Affine(2.0, 0.0, 0.5)) );
+    CHECK( map.manipulability(Affine(2.0, 0.0, 0.5)) == 0.0 );
+    CHECK_FALSE( map.is_reachable(Affine(0.0, 0.0, -0.3)) );
+    CHECK_FALSE( map.is_reachable(poses[0], 1.0) );
+
+    // Loaded from a memory mapping
+    const TemporaryFile file {"reachability-test.map"};
+    map.write(file.filename);
+    const ReachabilityMap loaded {file.filename};
+    CHECK( loaded.bin_count() == map.bin_count() );
+    CHECK( loaded.F_T_EE().isApprox(kinematics.F_T_EE) );
+
+    Eigen::Matrix<double, 16, Eigen::Dynamic> pose_matrix(16, poses.size());
+    for (size_t i = 0; i < poses.size(); i += 1) {
+        pose_matrix.col(i) = Eigen::Map<const Eigen::Matrix<double, 16, 1>>(poses[i].array().data());
+    }
+    const auto manipulabilities = loaded.manipulability(pose_matrix);
+    bool all_equal {true};
+    for (size_t i = 0; i < poses.size(); i += 1) {
+        all_equal &= (manipulabilities(i) == map.manipulability(poses[i])) && (loaded.is_reachable(poses[i]) == map.is_reachable(poses[i]));
+    }
+    CHECK( all_equal );
+}
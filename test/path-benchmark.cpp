@@ -0,0 +1,105 @@
+#include <chrono>
+#include <cstdio>
+#include <optional>
+#include <random>
+#include <string>
+
+#include <sys/resource.h>
+
+#include <movex/path/path.hpp>
+#include <movex/path/time_parametrization.hpp>
+
+
+using namespace movex;
+
+
+//! Random walk of Cartesian waypoints with a roughly constant distance
+std::vector<Affine> random_waypoints(size_t n, std::mt19937& gen) {
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+
+    std::vector<Affine> waypoints(n);
+    Vector7d vector = Vector7d::Zero();
+    for (size_t i = 0; i < n; i += 1) {
+        waypoints[i] = Affine(vector);
+        for (size_t j = 0; j < 6; j += 1) {
+            vector(j) += ((j < 3) ? 0.05 : 0.1) * dist(gen);
+        }
+    }
+    return waypoints;
+}
+
+//! Average duration of f in [s], repeated until the minimal total duration is reached
+template<class F>
+double measure(F f, double min_duration = 0.2) {
+    const auto start = std::chrono::steady_clock::now();
+    size_t repetitions {0};
+    double duration {0.0};
+    do {
+        f();
+        repetitions += 1;
+        duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (duration < min_duration);
+    return duration / repetitions;
+}
+
+//! Peak resident memory of the process in [MiB]
+double peak_memory() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0; // ru_maxrss is given in [KiB] on Linux
+}
+
+
+//! Usage: path-benchmark [max-waypoints], reports the throughput of the path construction, segment lookup, pose
+//! evaluation and time parametrization, as well as the duration of the trajectory and the peak memory so far
+int main(int argc, char *argv[]) {
+    const size_t max_waypoints = (argc > 1) ? std::stoul(argv[1]) : 10000;
+    const size_t number_samples {100000};
+
+    std::mt19937 gen(42);
+    auto tp = TimeParametrization(0.001);
+    auto max_velocity = std::array<double, 7> {{1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0}};
+    auto max_acceleration = std::array<double, 7> {{4.0, 4.0, 4.0, 4.0, 4.0, 4.0, 4.0}};
+    auto max_jerk = std::array<double, 7> {{40.0, 40.0, 40.0, 40.0, 40.0, 40.0, 40.0}};
+    const Affine frame {0.0, 0.0, 0.1034};
+
+    std::printf("%9s %7s %9s | %14s %14s %14s %14s | %12s %12s\n", "waypoints", "blend", "segments", "path [wp/s]", "local [1/s]", "q [1/s]", "param [st/s]", "duration [s]", "peak [MiB]");
+
+    volatile double sink {0.0};
+    for (const size_t n: {2, 10, 100, 1000, 10000}) {
+        if (n > max_waypoints) {
+            break;
+        }
+        const auto waypoints = random_waypoints(n, gen);
+
+        for (const double blend_max_distance: {0.0, 0.01, 0.05}) {
+            std::optional<Path> path;
+            const double path_time = measure([&]() { path.emplace(waypoints, blend_max_distance); });
+
+            std::uniform_real_distribution<double> s_dist(0.0, path->get_length());
+            std::vector<double> s_samples(number_samples);
+            for (auto& s: s_samples) {
+                s = s_dist(gen);
+            }
+
+            const double local_time = measure([&]() {
+                for (const double s: s_samples) {
+                    sink = sink + std::get<1>(path->get_local(s));
+                }
+            });
+
+            const double q_time = measure([&]() {
+                for (const double s: s_samples) {
+                    sink = sink + path->q(s, frame)(0);
+                }
+            });
+
+            std::optional<Trajectory> trajectory;
+            const double parametrize_time = measure([&]() { trajectory.emplace(tp.parametrize(*path, max_velocity, max_acceleration, max_jerk)); }, 0.0);
+
+            std::printf("%9zu %7.3f %9zu | %14.4g %14.4g %14.4g %14.4g | %12.3f %12.1f\n", n, blend_max_distance, path->segments.size(), n / path_time, number_samples / local_time, number_samples / q_time, trajectory->states.size() / parametrize_time, trajectory->states.back().t, peak_memory());
+        }
+    }
+
+    return 0;
+}
@@ -1,11 +1,21 @@
 #define CATCH_CONFIG_MAIN
+#include <cstdio>
+#include <ctime>
 #include <random>
 
 #include <catch2/catch.hpp>
 #include <Eigen/Core>
 
+#include <movex/path/blend_optimizer.hpp>
+#include <movex/path/collision_check.hpp>
+#include <movex/path/elbow_optimizer.hpp>
+#include <movex/path/joint_limit_check.hpp>
+#include <movex/path/joint_trajectory_conversion.hpp>
+#include <movex/path/parallel_parametrization.hpp>
 #include <movex/path/path.hpp>
 #include <movex/path/time_parametrization.hpp>
+#include <movex/path/trajectory_cache.hpp>
+#include <movex/path/trajectory_file.hpp>
 
 
 using namespace movex;
@@ -53,3 +63,940 @@ TEST_CASE("Path from affines and blending") {
         check_path(waypoints, blend_max);
     }
 }
+
+
+TEST_CASE("Quintic spline path") {
+    srand(45);
+
+    for (size_t i = 0; i < 256; i += 1) {
+        const size_t n = 2 + i % 6;
+
+        std::vector<Affine> waypoints(n);
+        for (size_t j = 0; j < n; j += 1) {
+            waypoints[j] = Affine((Vector7d)Vector7d::Random());
+        }
+
+        auto path = Path(waypoints, Path::Interpolation::QuinticSpline);
+        REQUIRE( path.segments.size() == n - 1 );
+
+        double s_start {0.0};
+        for (size_t j = 0; j < path.segments.size(); j += 1) {
+            auto segment = path.segments[j];
+            const double length = segment->get_length();
+            CAPTURE( j );
+
+            // Passes through the waypoints
+            CHECK( segment->q(0.0).head<3>().isApprox(waypoints[j].translation(), 1e-9) );
+            CHECK( segment->q(length).head<3>().isApprox(waypoints[j + 1].translation(), 1e-9) );
+
+            // Continuous curvature at the waypoints
+            if (j > 0) {
+                auto left = path.segments[j - 1];
+                CHECK( (left->pdq(left->get_length()) - segment->pdq(0.0)).norm() < 1e-9 );
+                CHECK( (left->pddq(left->get_length()) - segment->pddq(0.0)).norm() < 1e-6 );
+            }
+
+            // Analytic derivative bounds enclose sampled values
+            const Vector7d max_pddq = segment->max_pddq();
+            const Vector7d max_pdddq = segment->max_pdddq();
+            for (size_t k = 0; k <= 100; k += 1) {
+                const double s = k * length / 100;
+                CHECK( (segment->pddq(s).array().abs() <= max_pddq.array() + 1e-9).all() );
+                CHECK( (segment->pdddq(s).array().abs() <= max_pdddq.array() + 1e-9).all() );
+            }
+
+            s_start += length;
+        }
+
+        CHECK( path.get_length() == Approx(s_start) );
+    }
+}
+
+
+TEST_CASE("Time parametrization within limits") {
+    srand(46);
+    std::default_random_engine gen;
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+
+    auto tp = TimeParametrization(0.001);
+
+    for (size_t i = 0; i < 64; i += 1) {
+        const size_t n = 2 + 4 * dist(gen);
+
+        std::vector<Affine> waypoints(n);
+        for (size_t j = 0; j < n; j += 1) {
+            waypoints[j] = Affine((Vector7d)Vector7d::Random());
+        }
+        auto path = (i % 2 == 0) ? Path(waypoints, 0.1 * dist(gen)) : Path(waypoints, Path::Interpolation::QuinticSpline);
+
+        Vector7d max_velocity, max_acceleration, max_jerk;
+        for (size_t dof = 0; dof < 7; dof += 1) {
+            max_velocity(dof) = 0.5 + dist(gen);
+            max_acceleration(dof) = 1.0 + 4 * dist(gen);
+            max_jerk(dof) = 10.0 + 40 * dist(gen);
+        }
+
+        std::array<double, 7> max_velocity_array, max_acceleration_array, max_jerk_array;
+        Eigen::Map<Vector7d>(max_velocity_array.data()) = max_velocity;
+        Eigen::Map<Vector7d>(max_acceleration_array.data()) = max_acceleration;
+        Eigen::Map<Vector7d>(max_jerk_array.data()) = max_jerk;
+
+        auto trajectory = tp.parametrize(path, max_velocity_array, max_acceleration_array, max_jerk_array);
+        CAPTURE( i );
+
+        REQUIRE( trajectory.states.size() > 1 );
+        CHECK( trajectory.states.front().s == 0.0 );
+        CHECK( trajectory.states.back().s == Approx(path.get_length()) );
+        CHECK( trajectory.states.back().ds == 0.0 );
+
+        bool within_limits {true};
+        for (const auto& state: trajectory.states) {
+            within_limits &= (path.dq(state.s, state.ds).array().abs() <= max_velocity.array() + 1e-9).all();
+            within_limits &= (path.ddq(state.s, state.ds, state.dds).array().abs() <= max_acceleration.array() + 1e-9).all();
+            within_limits &= (path.dddq(state.s, state.ds, state.dds, state.ddds).array().abs() <= max_jerk.array() + 1e-6).all();
+        }
+        CHECK( within_limits );
+    }
+}
+
+
+TEST_CASE("Time parametrization slows down only for restrictive segments") {
+    auto tp = TimeParametrization(0.001);
+
+    auto max_limits = std::array<double, 7> {{1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0}};
+
+    auto corner_path = Path({Affine(0, 0, 0), Affine(1, 0, 0), Affine(1, 1, 0)}, 0.0);
+    auto blend_path = Path({Affine(0, 0, 0), Affine(1, 0, 0), Affine(1, 1, 0)}, 0.2);
+
+    auto corner_trajectory = tp.parametrize(corner_path, max_limits, max_limits, max_limits);
+    auto blend_trajectory = tp.parametrize(blend_path, max_limits, max_limits, max_limits);
+
+    // The blend is more restrictive than the straight lines, but still faster than stopping at the corner
+    CHECK( blend_trajectory.states.back().t < corner_trajectory.states.back().t );
+}
+
+
+TEST_CASE("Blending multiple corners is faster than stopping") {
+    auto tp = TimeParametrization(0.001);
+
+    auto max_velocity = std::array<double, 7> {{1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0}};
+    auto max_acceleration = std::array<double, 7> {{4.0, 4.0, 4.0, 4.0, 4.0, 4.0, 4.0}};
+    auto max_jerk = std::array<double, 7> {{40.0, 40.0, 40.0, 40.0, 40.0, 40.0, 40.0}};
+
+    std::vector<Affine> zig_zag;
+    for (size_t i = 0; i < 11; i += 1) {
+        zig_zag.emplace_back(0.1 * i, (i % 2) * 0.1, 0.0);
+    }
+
+    const double stop_duration = tp.parametrize(Path(zig_zag, 0.0), max_velocity, max_acceleration, max_jerk).states.back().t;
+    for (double blend_max_distance: {0.02, 0.05}) {
+        auto path = Path(zig_zag, blend_max_distance);
+        auto trajectory = tp.parametrize(path, max_velocity, max_acceleration, max_jerk);
+        CAPTURE( blend_max_distance );
+
+        bool within_limits {true};
+        for (const auto& state: trajectory.states) {
+            within_limits &= (path.ddq(state.s, state.ds, state.dds).array().abs() <= 4.0 + 1e-9).all();
+            within_limits &= (path.dddq(state.s, state.ds, state.dds, state.ddds).array().abs() <= 40.0 + 1e-6).all();
+        }
+        CHECK( within_limits );
+        CHECK( trajectory.states.back().t <= stop_duration );
+    }
+}
+
+
+TEST_CASE("Streamed time parametrization with short lookahead") {
+    srand(47);
+    std::default_random_engine gen;
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+
+    auto tp = TimeParametrization(0.001);
+    tp.lookahead = 0.5;
+
+    auto max_limits = std::array<double, 7> {{1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0}};
+    const Vector7d max_vector = Vector7d::Ones();
+
+    for (size_t i = 0; i < 16; i += 1) {
+        const size_t n = 6 + 10 * dist(gen);
+
+        std::vector<Affine> waypoints(n);
+        for (size_t j = 0; j < n; j += 1) {
+            waypoints[j] = Affine((Vector7d)Vector7d::Random());
+        }
+        auto path = (i % 2 == 0) ? Path(waypoints, 0.1 * dist(gen)) : Path(waypoints, Path::Interpolation::QuinticSpline);
+        CAPTURE( i );
+
+        auto stream = tp.stream(path, max_limits, max_limits, max_limits);
+        CHECK( stream.get_state().s == 0.0 );
+
+        bool within_limits {true};
+        size_t steps {0};
+        while (!stream.is_finished() && steps < 1000000) {
+            const auto& state = stream.step();
+            within_limits &= (path.dq(state.s, state.ds).array().abs() <= max_vector.array() + 1e-9).all();
+            within_limits &= (path.ddq(state.s, state.ds, state.dds).array().abs() <= max_vector.array() + 1e-9).all();
+            within_limits &= (path.dddq(state.s, state.ds, state.dds, state.ddds).array().abs() <= max_vector.array() + 1e-6).all();
+            steps += 1;
+        }
+        CHECK( within_limits );
+        REQUIRE( stream.is_finished() );
+        CHECK( stream.get_state().s == Approx(path.get_length()) );
+        CHECK( stream.get_state().ds == 0.0 );
+
+        // Planning ahead over the whole path is at least as fast
+        auto trajectory = tp.parametrize(path, max_limits, max_limits, max_limits);
+        CHECK( trajectory.states.back().t <= stream.get_state().t + 1e-9 );
+    }
+}
+
+
+TEST_CASE("Streamed time parametrization has a bounded step time") {
+    std::vector<Affine> waypoints;
+    for (size_t i = 0; i < 1000; i += 1) {
+        waypoints.emplace_back(0.01 * i, 0.05 * std::sin(0.02 * i), 0.0);
+    }
+
+    auto tp = TimeParametrization(0.001);
+    tp.lookahead = 4.0;
+    auto max_limits = std::array<double, 7> {{1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0}};
+
+    // The processor time excludes interruptions by other processes. The stream samples its whole first window when
+    // constructed, while each step only extends the window by the distance moved.
+    auto duration_since = [](std::clock_t start) {
+        return double(std::clock() - start) / CLOCKS_PER_SEC;
+    };
+
+    const std::clock_t start = std::clock();
+    auto stream = tp.stream(Path(waypoints, 0.005), max_limits, max_limits, max_limits);
+    const double window_duration = duration_since(start);
+
+    double max_step_duration {0.0};
+    while (!stream.is_finished()) {
+        const std::clock_t step_start = std::clock();
+        stream.step();
+        max_step_duration = std::max(max_step_duration, duration_since(step_start));
+    }
+    CHECK( max_step_duration < window_duration / 10 );
+}
+
+
+TEST_CASE("Trajectory file round trip") {
+    srand(48);
+
+    auto tp = TimeParametrization(0.001);
+    auto max_limits = std::array<double, 7> {{1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0}};
+    const std::string filename {"path-test-trajectory.bin"};
+
+    for (size_t i = 0; i < 4; i += 1) {
+        std::vector<Affine> waypoints(4);
+        for (size_t j = 0; j < waypoints.size(); j += 1) {
+            waypoints[j] = Affine((Vector7d)Vector7d::Random());
+        }
+        auto path = (i % 2 == 0) ? Path(waypoints, 0.05) : Path(waypoints, Path::Interpolation::QuinticSpline);
+        auto trajectory = tp.parametrize(path, max_limits, max_limits, max_limits);
+        CAPTURE( i );
+
+        TrajectoryFile::write(filename, trajectory, 0.001);
+        auto mapped = MappedTrajectory(filename);
+
+        CHECK( mapped.delta_time == 0.001 );
+        REQUIRE( mapped.size() == trajectory.states.size() );
+        REQUIRE( mapped.path.segments.size() == path.segments.size() );
+        CHECK( mapped.path.get_length() == path.get_length() );
+
+        bool is_equal {true};
+        for (size_t j = 0; j < mapped.size(); j += 1) {
+            const auto& state = trajectory.states[j];
+            is_equal &= (mapped[j].t == state.t && mapped[j].s == state.s && mapped[j].ds == state.ds && mapped[j].dds == state.dds && mapped[j].ddds == state.ddds);
+            is_equal &= (mapped.path.q(state.s) == path.q(state.s) && mapped.path.pdddq(state.s) == path.pdddq(state.s));
+        }
+        CHECK( is_equal );
+    }
+
+    std::remove(filename.c_str());
+    CHECK_THROWS( MappedTrajectory(filename) );
+}
+
+
+TEST_CASE("Trajectory cache") {
+    auto tp = TimeParametrization(0.001);
+    auto max_limits = std::array<double, 7> {{1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0}};
+
+    const std::vector<Waypoint> waypoints {Waypoint(Affine(0.2, 0.0, 0.0)), Waypoint(Affine(0.2, 0.2, 0.0))};
+    const Affine start {0.0, 0.0, 0.0};
+    auto key = TrajectoryCache::get_key(waypoints, Path::Interpolation::Linear, Affine(), max_limits, max_limits, max_limits, 0.001);
+
+    auto path = Path({start, Affine(0.2, 0.0, 0.0), Affine(0.2, 0.2, 0.0)});
+    auto trajectory = std::make_shared<Trajectory>(tp.parametrize(path, max_limits, max_limits, max_limits));
+
+    auto cache = TrajectoryCache();
+    cache.insert(key, start, trajectory);
+    CHECK( cache.size() == 1 );
+    CHECK( cache.find(key, start) == trajectory );
+    CHECK( cache.find(key, Affine(0.00005, 0.0, 0.0)) == trajectory );
+    CHECK( cache.find(key, Affine(0.01, 0.0, 0.0)) == nullptr );
+
+    // Every planning input is part of the key
+    auto slower_limits = max_limits;
+    slower_limits[2] = 0.5;
+    CHECK( cache.find(TrajectoryCache::get_key(waypoints, Path::Interpolation::QuinticSpline, Affine(), max_limits, max_limits, max_limits, 0.001), start) == nullptr );
+    CHECK( cache.find(TrajectoryCache::get_key(waypoints, Path::Interpolation::Linear, Affine(0.0, 0.0, 0.1), max_limits, max_limits, max_limits, 0.001), start) == nullptr );
+    CHECK( cache.find(TrajectoryCache::get_key(waypoints, Path::Interpolation::Linear, Affine(), max_limits, slower_limits, max_limits, 0.001), start) == nullptr );
+
+    // Trajectories planned in joint space only match the same start joint positions
+    const Vector7d q_start = (Vector7d() << 0.0, -M_PI / 4, 0.0, -3 * M_PI / 4, 0.0, M_PI / 2, M_PI / 4).finished();
+    Vector7d q_other = q_start;
+    q_other(2) += 0.1;
+    const auto joint_key = TrajectoryCache::get_key(waypoints, Path::Interpolation::Linear, Affine(), max_limits, max_limits, max_limits, 0.001, std::numeric_limits<double>::infinity(), true, false, q_start);
+    CHECK( !(joint_key == TrajectoryCache::get_key(waypoints, Path::Interpolation::Linear, Affine(), max_limits, max_limits, max_limits, 0.001, std::numeric_limits<double>::infinity(), true, false)) );
+    CHECK( !(joint_key == TrajectoryCache::get_key(waypoints, Path::Interpolation::Linear, Affine(), max_limits, max_limits, max_limits, 0.001, std::numeric_limits<double>::infinity(), true, false, q_other)) );
+    CHECK( joint_key == TrajectoryCache::get_key(waypoints, Path::Interpolation::Linear, Affine(), max_limits, max_limits, max_limits, 0.001, std::numeric_limits<double>::infinity(), true, false, q_start) );
+
+    // The least recently used trajectory is evicted first
+    auto other_key = TrajectoryCache::get_key(waypoints, Path::Interpolation::Linear, Affine(), slower_limits, max_limits, max_limits, 0.001);
+    auto third_key = TrajectoryCache::get_key(waypoints, Path::Interpolation::Linear, Affine(), max_limits, max_limits, slower_limits, 0.001);
+
+    cache.max_memory = 2 * cache.get_memory() + 1;
+    cache.insert(other_key, start, trajectory);
+    CHECK( cache.size() == 2 );
+    CHECK( cache.find(key, start) == trajectory );
+
+    cache.insert(third_key, start, trajectory);
+    CHECK( cache.size() == 2 );
+    CHECK( cache.find(other_key, start) == nullptr );
+    CHECK( cache.find(key, start) == trajectory );
+    CHECK( cache.find(third_key, start) == trajectory );
+    CHECK( cache.get_memory() <= cache.max_memory );
+
+    cache.clear();
+    CHECK( cache.size() == 0 );
+    CHECK( cache.get_memory() == 0 );
+}
+
+
+TEST_CASE("Parallel parametrization of candidate paths") {
+    auto tp = TimeParametrization(0.001);
+    auto max_limits = std::array<double, 7> {{1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0}};
+    const std::vector<Affine> affines {Affine(0.0, 0.0, 0.0), Affine(0.4, 0.0, 0.0), Affine(0.4, 0.4, 0.0), Affine(0.0, 0.4, 0.2)};
+
+    std::vector<ParallelParametrization::Candidate> candidates;
+    candidates.emplace_back(std::vector<Waypoint> {Waypoint(affines[0])}, Path::Interpolation::Linear, max_limits, max_limits, max_limits); // Invalid path
+    for (double blend_max_distance: {0.0, 0.01, 0.03, 0.1, 0.05}) {
+        std::vector<Waypoint> waypoints;
+        for (const auto& affine: affines) {
+            waypoints.emplace_back(affine, std::nullopt, blend_max_distance);
+        }
+        candidates.emplace_back(waypoints, Path::Interpolation::Linear, max_limits, max_limits, max_limits);
+    }
+
+    std::optional<size_t> sequential_index;
+    double sequential_duration {std::numeric_limits<double>::infinity()};
+    for (size_t i = 1; i < candidates.size(); i += 1) {
+        auto trajectory = tp.parametrize(Path(candidates[i].waypoints), max_limits, max_limits, max_limits);
+        if (trajectory.states.back().t < sequential_duration) {
+            sequential_duration = trajectory.states.back().t;
+            sequential_index = i;
+        }
+    }
+
+    for (size_t number_threads: {1, 4}) {
+        auto result = ParallelParametrization(0.001, number_threads).fastest(candidates);
+        REQUIRE( result );
+        CHECK( result->index == sequential_index );
+        CHECK( result->trajectory.states.back().t == Approx(sequential_duration) );
+    }
+
+    CHECK_FALSE( ParallelParametrization(0.001).fastest({candidates[0]}) );
+}
+
+
+TEST_CASE("Slerp path") {
+    // The shorter rotation between these yaw angles crosses +-pi, where linear Euler interpolation turns the long way
+    const Affine start {0.0, 0.0, 0.0, 3.0, 0.0, 0.0};
+    const Affine end {0.3, 0.0, 0.0, -3.0, 0.0, 0.0};
+    const double angle = 2 * M_PI - 6.0;
+
+    auto path = Path({start, end}, Path::Interpolation::Slerp);
+    REQUIRE( path.segments.size() == 1 );
+    CHECK( path.get_length() == Approx(std::sqrt(std::pow(0.3, 2) + std::pow(angle, 2))) );
+    CHECK( Path({start, end}).get_length() > 6.0 );
+
+    CHECK( path.pose(0.0).isApprox(start) );
+    CHECK( path.pose(path.get_length()).isApprox(end) );
+
+    const auto middle = path.pose(path.get_length() / 2);
+    CHECK( middle.translation().isApprox(Eigen::Vector3d(0.15, 0.0, 0.0)) );
+    CHECK( std::abs(middle.a()) == Approx(M_PI) );
+
+    // Pose and its vector representation agree, and the angular velocity is constant about the rotation axis
+    for (double s: {0.0, 0.1, 0.2, path.get_length()}) {
+        CHECK( Affine(path.q(s)).isApprox(path.pose(s)) );
+        CHECK( path.pdq(s).segment<3>(3).isApprox(Eigen::Vector3d(0.0, 0.0, angle / path.get_length())) );
+    }
+
+    auto tp = TimeParametrization(0.001);
+    auto max_limits = std::array<double, 7> {{1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0}};
+    auto trajectory = tp.parametrize(path, max_limits, max_limits, max_limits);
+    CHECK( trajectory.states.back().s == Approx(path.get_length()) );
+
+    const std::string filename {"path-test-slerp.bin"};
+    TrajectoryFile::write(filename, trajectory, 0.001);
+    auto mapped = MappedTrajectory(filename);
+    CHECK( mapped.path.pose(0.2).isApprox(path.pose(0.2)) );
+    std::remove(filename.c_str());
+}
+
+
+TEST_CASE("Appending to a streamed path") {
+    const std::vector<Affine> affines {Affine(0.0, 0.0, 0.0), Affine(0.5, 0.0, 0.0), Affine(0.5, 0.5, 0.0), Affine(0.0, 0.5, 0.2), Affine(0.0, 0.0, 0.2)};
+    auto to_waypoints = [](const std::vector<Affine>& affines, double blend_max_distance) {
+        std::vector<Waypoint> waypoints;
+        for (const auto& affine: affines) {
+            waypoints.emplace_back(affine, std::nullopt, blend_max_distance);
+        }
+        return waypoints;
+    };
+
+    // Appending to a path gives the same path as creating it at once
+    auto path = Path({affines[0], affines[1], affines[2]}, 0.05);
+    path.append(to_waypoints({affines[3], affines[4]}, 0.05), 0.05);
+    auto complete_path = Path(affines, 0.05);
+    REQUIRE( path.segments.size() == complete_path.segments.size() );
+    CHECK( path.get_length() == Approx(complete_path.get_length()) );
+    for (double s = 0.0; s < path.get_length(); s += 0.05) {
+        CHECK( path.q(s).isApprox(complete_path.q(s)) );
+    }
+
+    auto tp = TimeParametrization(0.001);
+    tp.lookahead = 0.3;
+    auto max_limits = std::array<double, 7> {{1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0}};
+
+    auto stream = tp.stream(Path({affines[0], affines[1], affines[2]}, 0.05), max_limits, max_limits, max_limits);
+    for (size_t i = 0; i < 500; i += 1) {
+        stream.step();
+    }
+    const double old_length = stream.get_path().get_length();
+    stream.append(to_waypoints({affines[3], affines[4]}, 0.05), 0.05);
+    CHECK( stream.get_path().get_length() > old_length );
+
+    bool within_limits {true};
+    double min_ds_at_old_end {std::numeric_limits<double>::infinity()};
+    while (!stream.is_finished()) {
+        const auto& state = stream.step();
+        const auto& current_path = stream.get_path();
+        within_limits &= (current_path.dq(state.s, state.ds).array().abs() <= 1.0 + 1e-9).all();
+        within_limits &= (current_path.ddq(state.s, state.ds, state.dds).array().abs() <= 1.0 + 1e-9).all();
+        within_limits &= (current_path.dddq(state.s, state.ds, state.dds, state.ddds).array().abs() <= 1.0 + 1e-6).all();
+        if (std::abs(state.s - old_length) < 0.05) {
+            min_ds_at_old_end = std::min(min_ds_at_old_end, state.ds);
+        }
+    }
+    CHECK( within_limits );
+    CHECK( stream.get_state().s == Approx(stream.get_path().get_length()) );
+
+    // The motion is blended through the former end of the path instead of stopping there
+    CHECK( min_ds_at_old_end > 0.0 );
+
+    // A finished stream continues from standstill
+    stream.append({Waypoint(Affine(0.0, 0.0, 0.0))});
+    CHECK_FALSE( stream.is_finished() );
+    while (!stream.is_finished()) {
+        stream.step();
+    }
+    CHECK( (stream.get_path().q(stream.get_state().s) - affines[0].vector_with_elbow(0.0)).norm() < 1e-9 );
+}
+
+
+TEST_CASE("Blend distance optimization") {
+    auto tp = TimeParametrization(0.001);
+    auto max_velocity = std::array<double, 7> {{1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0}};
+    auto max_acceleration = std::array<double, 7> {{4.0, 4.0, 4.0, 4.0, 4.0, 4.0, 4.0}};
+    auto max_jerk = std::array<double, 7> {{40.0, 40.0, 40.0, 40.0, 40.0, 40.0, 40.0}};
+    auto optimizer = BlendOptimizer(max_velocity, max_acceleration, max_jerk);
+    const double tolerance {0.2};
+
+    std::vector<Waypoint> waypoints;
+    for (const auto& affine: {Affine(0.0, 0.0, 0.0), Affine(0.5, 0.0, 0.0), Affine(0.5, 0.5, 0.0), Affine(1.0, 0.6, 0.1), Affine(1.0, 1.0, 0.1), Affine(0.2, 1.2, 0.0)}) {
+        waypoints.emplace_back(affine, std::nullopt, 0.0);
+    }
+    auto tolerance_waypoints = waypoints;
+    for (auto& waypoint: tolerance_waypoints) {
+        waypoint.blend_max_distance = tolerance;
+    }
+
+    const auto optimized = optimizer.optimize(waypoints, tolerance);
+    REQUIRE( optimized.size() == waypoints.size() );
+    for (const auto& waypoint: optimized) {
+        CHECK( waypoint.blend_max_distance >= 0.0 );
+        CHECK( waypoint.blend_max_distance <= tolerance );
+    }
+
+    const double optimized_duration = optimizer.predict_duration(Path(optimized));
+    CHECK( optimized_duration <= optimizer.predict_duration(Path(waypoints)) );
+    CHECK( optimized_duration <= optimizer.predict_duration(Path(tolerance_waypoints)) );
+
+    // The predicted improvement holds for the time parametrization as well
+    auto optimized_trajectory = tp.parametrize(Path(optimized), max_velocity, max_acceleration, max_jerk);
+    CHECK( optimized_trajectory.states.back().t < tp.parametrize(Path(waypoints), max_velocity, max_acceleration, max_jerk).states.back().t );
+    CHECK( optimized_trajectory.states.back().t < tp.parametrize(Path(tolerance_waypoints), max_velocity, max_acceleration, max_jerk).states.back().t );
+}
+
+
+TEST_CASE("Batch evaluation and resampling") {
+    srand(51);
+
+    auto tp = TimeParametrization(0.001);
+    auto max_limits = std::array<double, 7> {{1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0}};
+
+    for (size_t i = 0; i < 4; i += 1) {
+        std::vector<Affine> waypoints(6);
+        for (size_t j = 0; j < waypoints.size(); j += 1) {
+            waypoints[j] = Affine((Vector7d)Vector7d::Random());
+        }
+        auto path = (i % 2 == 0) ? Path(waypoints, 0.1) : Path(waypoints, Path::Interpolation::QuinticSpline);
+        CAPTURE( i );
+
+        // Sorted positions including the segment boundaries, followed by unsorted ones
+        const size_t n = 200;
+        Eigen::VectorXd s(n + 20), ds(n + 20), dds(n + 20), ddds(n + 20);
+        for (size_t j = 0; j < n; j += 1) {
+            s(j) = path.get_length() * j / (n - 1);
+        }
+        s.tail(20) = path.get_length() * (Eigen::VectorXd::Random(20).array() + 1.0) / 2;
+        ds.setRandom();
+        dds.setRandom();
+        ddds.setRandom();
+
+        const auto q = path.q(s);
+        const auto pdddq = path.pdddq(s);
+        const auto dddq = path.dddq(s, ds, dds, ddds);
+        REQUIRE( q.cols() == s.size() );
+
+        bool is_equal {true};
+        for (Eigen::Index j = 0; j < s.size(); j += 1) {
+            is_equal &= (q.col(j) == path.q(s(j)) && pdddq.col(j) == path.pdddq(s(j)));
+            is_equal &= (dddq.col(j) == path.dddq(s(j), ds(j), dds(j), ddds(j)));
+        }
+        CHECK( is_equal );
+
+        auto trajectory = tp.parametrize(path, max_limits, max_limits, max_limits);
+
+        // Resampling with the original time step reproduces the states
+        auto same = trajectory.resample(0.001);
+        REQUIRE( same.states.size() == trajectory.states.size() );
+        double max_difference {0.0};
+        for (size_t j = 0; j < same.states.size(); j += 1) {
+            max_difference = std::max({max_difference, std::abs(same.states[j].s - trajectory.states[j].s), std::abs(same.states[j].ds - trajectory.states[j].ds), std::abs(same.states[j].dds - trajectory.states[j].dds)});
+        }
+        CHECK( max_difference < 1e-9 );
+
+        // A coarser time step matches every tenth state
+        auto coarse = trajectory.resample(0.01);
+        CHECK( coarse.states.back().t == trajectory.states.back().t );
+        CHECK( coarse.states.back().s == trajectory.states.back().s );
+        max_difference = 0.0;
+        for (size_t j = 0; j < coarse.states.size() - 1; j += 1) {
+            const auto& state = trajectory.states[10 * j];
+            max_difference = std::max({max_difference, std::abs(coarse.states[j].t - state.t), std::abs(coarse.states[j].s - state.s), std::abs(coarse.states[j].ds - state.ds)});
+        }
+        CHECK( max_difference < 1e-9 );
+
+        CHECK_THROWS( trajectory.resample(0.0) );
+    }
+}
+
+
+TEST_CASE("Simplification of dense waypoints") {
+    // Quarter circle with a rotation around the z-axis and a slowly changing elbow
+    const size_t n = 2000;
+    std::vector<Waypoint> waypoints;
+    for (size_t i = 0; i < n; i += 1) {
+        const double phi = M_PI / 2 * i / (n - 1);
+        waypoints.emplace_back(Affine(0.3 + 0.2 * std::cos(phi), 0.2 * std::sin(phi), 0.4, phi, 0.0, M_PI), 0.2 * phi, 0.0);
+    }
+
+    const double max_translation_deviation {1e-3}, max_rotation_deviation {1e-2};
+    const auto simplified = Path::simplify(waypoints, max_translation_deviation, max_rotation_deviation);
+    CHECK( simplified.size() < n / 20 );
+    CHECK( simplified.front().affine.isApprox(waypoints.front().affine) );
+    CHECK( simplified.back().affine.isApprox(waypoints.back().affine) );
+    CHECK( *simplified.back().elbow == Approx(*waypoints.back().elbow) );
+
+    // Every original waypoint is close to the simplified path
+    const auto path = Path(simplified);
+    const size_t samples = 20000;
+    Eigen::VectorXd s = Eigen::VectorXd::LinSpaced(samples, 0.0, path.get_length());
+    const auto q = path.q(s);
+
+    double max_translation {0.0}, max_rotation {0.0};
+    for (const auto& waypoint: waypoints) {
+        const Vector7d vector = waypoint.affine.vector_with_elbow(*waypoint.elbow);
+        Eigen::Index nearest;
+        (q.topRows<3>().colwise() - vector.head<3>()).colwise().squaredNorm().minCoeff(&nearest);
+
+        max_translation = std::max(max_translation, (q.col(nearest).head<3>() - vector.head<3>()).norm());
+        max_rotation = std::max(max_rotation, Affine((Vector7d)q.col(nearest)).quaternion().angularDistance(waypoint.affine.quaternion()));
+    }
+    CHECK( max_translation < max_translation_deviation + 1e-4 );
+    CHECK( max_rotation < max_rotation_deviation + 1e-3 );
+
+    // Collinear waypoints reduce to their ends
+    const std::vector<Waypoint> line {Waypoint(Affine(0.0, 0.0, 0.0)), Waypoint(Affine(0.1, 0.0, 0.0)), Waypoint(Affine(0.2, 0.0, 0.0)), Waypoint(Affine(0.3, 0.0, 0.0))};
+    CHECK( Path::simplify(line, 1e-6, 1e-6).size() == 2 );
+}
+
+
+TEST_CASE("Constant tool velocity") {
+    auto tp = TimeParametrization(0.001);
+    tp.max_tool_velocity = 0.1;
+
+    auto max_velocity = std::array<double, 7> {{2.0, 2.0, 2.0, 2.0, 2.0, 2.0, 2.0}};
+    auto max_acceleration = std::array<double, 7> {{10.0, 10.0, 10.0, 10.0, 10.0, 10.0, 10.0}};
+    auto max_jerk = std::array<double, 7> {{100.0, 100.0, 100.0, 100.0, 100.0, 100.0, 100.0}};
+
+    // Rectangle with blended corners and a slight rotation along the way
+    auto path = Path({
+        Affine(0.4, 0.0, 0.3),
+        Affine(0.6, 0.0, 0.3, 0.2),
+        Affine(0.6, 0.2, 0.3, 0.4),
+        Affine(0.4, 0.2, 0.3, 0.4),
+    }, 0.02);
+    auto trajectory = tp.parametrize(path, max_velocity, max_acceleration, max_jerk);
+
+    size_t constant_states {0};
+    double max_tool_speed {0.0};
+    for (const auto& state: trajectory.states) {
+        const double tool_speed = path.dq(state.s, state.ds).head<3>().norm();
+        max_tool_speed = std::max(max_tool_speed, tool_speed);
+        constant_states += (tool_speed > 0.099);
+    }
+    // As for the joint velocity limits, the generator follows a falling velocity curve at blends only approximately
+    CHECK( max_tool_speed <= 0.1 * 1.005 );
+
+    // The tool speed is only reduced while ramping in and out, not at the blends
+    CHECK( constant_states > 0.9 * trajectory.states.size() );
+
+    // Without the tool velocity, the trajectory is faster
+    tp.max_tool_velocity = std::numeric_limits<double>::infinity();
+    CHECK( tp.parametrize(path, max_velocity, max_acceleration, max_jerk).states.back().t < trajectory.states.back().t );
+}
+
+
+TEST_CASE("Joint space path") {
+    auto tp = TimeParametrization(0.001);
+
+    // Limits of the Panda joints
+    auto max_velocity = std::array<double, 7> {{2.175, 2.175, 2.175, 2.175, 2.610, 2.610, 2.610}};
+    auto max_acceleration = std::array<double, 7> {{15.0, 7.5, 10.0, 12.5, 15.0, 20.0, 20.0}};
+    auto max_jerk = std::array<double, 7> {{7500.0, 3750.0, 5000.0, 6250.0, 7500.0, 10000.0, 10000.0}};
+
+    std::vector<Vector7d> waypoints {
+        (Vector7d() << 0.0, -0.785, 0.0, -2.356, 0.0, 1.571, 0.785).finished(),
+        (Vector7d() << 1.2, -0.3, 0.2, -1.8, 0.1, 1.9, 0.3).finished(),
+        (Vector7d() << 1.5, 0.2, -0.4, -1.2, -0.3, 1.4, 1.2).finished(),
+        (Vector7d() << -0.5, -0.2, 0.1, -2.0, 0.4, 2.2, -0.4).finished(),
+    };
+
+    CHECK_THROWS( Path(std::vector<Vector7d> {waypoints[0]}) );
+
+    auto path = Path(waypoints, 0.2);
+    CHECK( (path.q(0.0) - waypoints.front()).norm() < 1e-12 );
+    CHECK( (path.q(path.get_length()) - waypoints.back()).norm() < 1e-12 );
+    CHECK( path.segments.size() == 5 );
+
+    auto trajectory = tp.parametrize(path, max_velocity, max_acceleration, max_jerk);
+
+    bool within_limits {true};
+    for (const auto& state: trajectory.states) {
+        within_limits &= (path.dq(state.s, state.ds).array().abs() <= Eigen::Map<Vector7d>(max_velocity.data()).array() * 1.005).all();
+        within_limits &= (path.ddq(state.s, state.ds, state.dds).array().abs() <= Eigen::Map<Vector7d>(max_acceleration.data()).array() + 1e-6).all();
+    }
+    CHECK( within_limits );
+    CHECK( trajectory.states.back().s == Approx(path.get_length()) );
+
+    // Blending in the joint space is faster than stopping at each waypoint
+    CHECK( trajectory.states.back().t < tp.parametrize(Path(waypoints), max_velocity, max_acceleration, max_jerk).states.back().t );
+}
+
+
+TEST_CASE("Joint limit check of a Cartesian path") {
+    auto tp = TimeParametrization(0.001);
+
+    // Cartesian limits of the robot's path motions
+    auto max_velocity = std::array<double, 7> {{0.85, 0.85, 0.85, 2.5, 2.5, 2.5, 0.7}};
+    auto max_acceleration = std::array<double, 7> {{2.6, 2.6, 2.6, 10.0, 10.0, 10.0, 1.3}};
+    auto max_jerk = std::array<double, 7> {{520.0, 520.0, 520.0, 2000.0, 2000.0, 2000.0, 260.0}};
+
+    const Kinematics kinematics;
+    const JointLimitCheck check {kinematics, {{2.175, 2.175, 2.175, 2.175, 2.610, 2.610, 2.610}}, {{15.0, 7.5, 10.0, 12.5, 15.0, 20.0, 20.0}}};
+
+    // Line passing close to the axis of the first joint, which needs to turn quickly there
+    const Vector7d q_home = (Vector7d() << 0.0, -M_PI / 4, 0.0, -3 * M_PI / 4, 0.0, M_PI / 2, M_PI / 4).finished();
+    Affine start = kinematics.forward(q_home), end;
+    start.set_x(0.35);
+    start.set_y(0.05);
+    start.set_z(0.6);
+    end = start;
+    end.set_x(-0.1);
+
+    const auto q_start = kinematics.inverse(start, q_home(6), q_home);
+    REQUIRE( q_start );
+
+    const auto path = Path({start, end});
+    const auto trajectory = tp.parametrize(path, max_velocity, max_acceleration, max_jerk);
+    const auto violations = check.check(trajectory, Affine(), *q_start);
+    REQUIRE( violations.size() > 0 );
+
+    const auto checked_trajectory = check.parametrize(tp, path, Affine(), *q_start, max_velocity, max_acceleration, max_jerk);
+    CHECK( check.check(checked_trajectory, Affine(), *q_start).empty() );
+
+    // Only the violating sections are slowed down
+    CHECK( checked_trajectory.states.back().t < 1.1 * trajectory.states.back().t );
+    for (const auto& state: checked_trajectory.states) {
+        for (const auto& violation: violations) {
+            if (violation.s_start <= state.s && state.s <= violation.s_end) {
+                CHECK( state.ds <= violation.max_ds );
+            }
+        }
+    }
+
+    // Poses out of the workspace are errors instead of being skipped
+    Affine unreachable = start;
+    unreachable.set_x(1.5);
+    const auto unreachable_path = Path({start, unreachable});
+    const auto unreachable_trajectory = tp.parametrize(unreachable_path, max_velocity, max_acceleration, max_jerk);
+    CHECK_THROWS( check.check(unreachable_trajectory, Affine(), *q_start) );
+    CHECK_THROWS( check.parametrize(tp, unreachable_path, Affine(), *q_start, max_velocity, max_acceleration, max_jerk) );
+}
+
+TEST_CASE("Collision check of a Cartesian path") {
+    std::default_random_engine gen(42);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+
+    auto point_segment_distance = [](const Eigen::Vector3d& p, const Eigen::Vector3d& a, const Eigen::Vector3d& b) {
+        const Eigen::Vector3d d = b - a;
+        const double t = std::clamp((p - a).dot(d) / d.squaredNorm(), 0.0, 1.0);
+        return (a + t * d - p).norm();
+    };
+
+    // Compare the distances to each obstacle type with points sampled densely along the link capsules
+    for (size_t i = 0; i < 90; i += 1) {
+        Vector7d q;
+        for (size_t j = 0; j < 7; j += 1) {
+            q(j) = Kinematics::min_joint_position[j] + (dist(gen) + 1) / 2 * (Kinematics::max_joint_position[j] - Kinematics::min_joint_position[j]);
+        }
+
+        const Eigen::Vector3d start {0.5 * dist(gen), 0.5 * dist(gen), 0.4 + 0.4 * dist(gen)}, end {0.5 * dist(gen), 0.5 * dist(gen), 0.4 + 0.4 * dist(gen)};
+        const Eigen::Vector3d normal {dist(gen), dist(gen), dist(gen)}, size {0.2 + 0.1 * dist(gen), 0.2 + 0.1 * dist(gen), 0.2 + 0.1 * dist(gen)};
+        const Affine box {start.x(), start.y(), start.z(), 3 * dist(gen), dist(gen), 3 * dist(gen)};
+        const double radius = 0.05 + 0.05 * dist(gen), offset = 0.3 * dist(gen);
+
+        CollisionCheck check;
+        auto obstacle_distance = [&](const Eigen::Vector3d& p) {
+            switch (i % 3) {
+                case 0: return point_segment_distance(p, start, end) - radius;
+                case 1: return ((box.data.linear().transpose() * (p - box.data.translation())).cwiseAbs() - size / 2).cwiseMax(0.0).norm();
+                default: return normal.normalized().dot(p) - offset / normal.norm();
+            }
+        };
+        switch (i % 3) {
+            case 0: check.add_capsule(start, end, radius); break;
+            case 1: check.add_box(box, size); break;
+            default: check.add_plane(normal, offset); break;
+        }
+
+        const auto frames = Kinematics::joint_frames(q);
+        double sampled_distance {std::numeric_limits<double>::infinity()};
+        for (const auto& [index, capsule]: check.link_capsules) {
+            const Eigen::Vector3d a = (frames[index] * capsule.start.homogeneous()).head<3>();
+            const Eigen::Vector3d b = (frames[index] * capsule.end.homogeneous()).head<3>();
+            for (size_t k = 0; k <= 1000; k += 1) {
+                sampled_distance = std::min(sampled_distance, obstacle_distance(a + k / 1000.0 * (b - a)) - capsule.radius);
+            }
+        }
+
+        CAPTURE( i );
+        CHECK( check.distance(q) <= sampled_distance + 1e-9 );
+        CHECK( check.distance(q) == Approx(sampled_distance).margin(1e-4) );
+    }
+
+    auto tp = TimeParametrization(0.001);
+    auto max_velocity = std::array<double, 7> {{0.85, 0.85, 0.85, 2.5, 2.5, 2.5, 0.7}};
+    auto max_acceleration = std::array<double, 7> {{2.6, 2.6, 2.6, 10.0, 10.0, 10.0, 1.3}};
+    auto max_jerk = std::array<double, 7> {{520.0, 520.0, 520.0, 2000.0, 2000.0, 2000.0, 260.0}};
+
+    // Line above a table, with a small sphere next to the hand
+    const Kinematics kinematics;
+    const Vector7d q_home = (Vector7d() << 0.0, -M_PI / 4, 0.0, -3 * M_PI / 4, 0.0, M_PI / 2, M_PI / 4).finished();
+    Affine start = kinematics.forward(q_home);
+    start.set_x(0.5);
+    start.set_y(-0.3);
+    start.set_z(0.3);
+    Affine end = start;
+    end.set_y(0.3);
+
+    const auto q_start = kinematics.inverse(start, q_home(6), q_home);
+    REQUIRE( q_start );
+
+    const auto path = Path({start, end});
+    const auto trajectory = tp.parametrize(path, max_velocity, max_acceleration, max_jerk);
+
+    CollisionCheck check {kinematics};
+    check.add_plane({0.0, 0.0, 1.0}, 0.0);
+    CHECK_FALSE( check.check(trajectory, Affine(), *q_start) );
+
+    check.add_sphere({0.5, 0.1, 0.45}, 0.03);
+    const auto contact = check.check(trajectory, Affine(), *q_start);
+    REQUIRE( contact );
+    CHECK( contact->distance < 0.0 );
+
+    // No state before the contact collides
+    Vector7d q = *q_start;
+    for (const auto& state: trajectory.states) {
+        q = kinematics.inverse(path.pose(state.s), q_home(6), q).value();
+        if (state.s > contact->s) {
+            break;
+        }
+        CHECK( check.distance(q) >= 0.0 );
+        CHECK( state.t <= contact->t );
+    }
+
+    // A detour out of reach between two reachable samples is not free, even if both samples are
+    Affine unreachable = start;
+    unreachable.set_x(1.5);
+    unreachable.set_y(0.0);
+    const auto detour_path = Path({start, unreachable, end});
+    const auto detour_trajectory = tp.parametrize(detour_path, max_velocity, max_acceleration, max_jerk);
+
+    CollisionCheck coarse_check {kinematics};
+    coarse_check.add_plane({0.0, 0.0, 1.0}, 0.0);
+    coarse_check.s_step = detour_path.get_length();
+    CHECK_THROWS( coarse_check.check(detour_trajectory, Affine(), *q_start) );
+}
+
+TEST_CASE("Conversion of a Cartesian trajectory to joint positions") {
+    auto tp = TimeParametrization(0.001);
+
+    // Full Cartesian limits of the robot, as the joint limits are checked on the joint positions
+    auto max_velocity = std::array<double, 7> {{1.7, 1.7, 1.7, 2.5, 2.5, 2.5, 2.175}};
+    auto max_acceleration = std::array<double, 7> {{13.0, 13.0, 13.0, 25.0, 25.0, 25.0, 10.0}};
+    auto max_jerk = std::array<double, 7> {{6500.0, 6500.0, 6500.0, 12500.0, 12500.0, 12500.0, 5000.0}};
+
+    const std::array<double, 7> max_joint_velocity {{2.175, 2.175, 2.175, 2.175, 2.610, 2.610, 2.610}};
+    const std::array<double, 7> max_joint_acceleration {{15.0, 7.5, 10.0, 12.5, 15.0, 20.0, 20.0}};
+    const std::array<double, 7> max_joint_jerk {{7500.0, 3750.0, 5000.0, 6250.0, 7500.0, 10000.0, 10000.0}};
+
+    const Kinematics kinematics;
+    const JointLimitCheck check {kinematics, max_joint_velocity, max_joint_acceleration, max_joint_jerk};
+    const JointTrajectoryConversion conversion {kinematics, max_joint_velocity, max_joint_acceleration, max_joint_jerk};
+
+    // Same line close to the axis of the first joint as for the joint limit check
+    const Vector7d q_home = (Vector7d() << 0.0, -M_PI / 4, 0.0, -3 * M_PI / 4, 0.0, M_PI / 2, M_PI / 4).finished();
+    Affine start = kinematics.forward(q_home), end;
+    start.set_x(0.35);
+    start.set_y(0.05);
+    start.set_z(0.6);
+    end = start;
+    end.set_x(-0.1);
+
+    const auto q_start = kinematics.inverse(start, q_home(6), q_home);
+    REQUIRE( q_start );
+
+    const auto path = Path({start, end});
+    CHECK_THROWS( conversion.convert(tp.parametrize(path, max_velocity, max_acceleration, max_jerk), Affine(), *q_start) );
+
+    const auto trajectory = check.parametrize(tp, path, Affine(), *q_start, max_velocity, max_acceleration, max_jerk);
+    CHECK( check.check(trajectory, Affine(), *q_start).empty() );
+
+    const auto q = conversion.convert(trajectory, Affine(), *q_start);
+    REQUIRE( q.size() == trajectory.states.size() );
+    CHECK( (q.front() - *q_start).norm() < 1e-12 );
+
+    bool follows_path {true};
+    for (size_t i = 0; i < q.size(); i += 1) {
+        const Affine pose = kinematics.forward(q[i]);
+        const Affine target = path.pose(trajectory.states[i].s);
+        follows_path &= (pose.translation() - target.translation()).norm() < 1e-6;
+        follows_path &= pose.quaternion().angularDistance(target.quaternion()) < 1e-6;
+        follows_path &= std::abs(q[i](6) - (*q_start)(6)) < 1e-12;
+    }
+    CHECK( follows_path );
+
+    // A start pose away from the given joint positions
+    Vector7d q_other = *q_start;
+    q_other(0) += 0.01;
+    CHECK_THROWS( conversion.convert(trajectory, Affine(), q_other) );
+}
+
+TEST_CASE("Elbow optimization along a Cartesian path") {
+    auto tp = TimeParametrization(0.001);
+
+    auto max_velocity = std::array<double, 7> {{1.7, 1.7, 1.7, 2.5, 2.5, 2.5, 2.175}};
+    auto max_acceleration = std::array<double, 7> {{13.0, 13.0, 13.0, 25.0, 25.0, 25.0, 10.0}};
+    auto max_jerk = std::array<double, 7> {{6500.0, 6500.0, 6500.0, 12500.0, 12500.0, 12500.0, 5000.0}};
+
+    const std::array<double, 7> max_joint_velocity {{2.175, 2.175, 2.175, 2.175, 2.610, 2.610, 2.610}};
+    const std::array<double, 7> max_joint_acceleration {{15.0, 7.5, 10.0, 12.5, 15.0, 20.0, 20.0}};
+    const std::array<double, 7> max_joint_jerk {{7500.0, 3750.0, 5000.0, 6250.0, 7500.0, 10000.0, 10000.0}};
+
+    const Kinematics kinematics;
+    const ElbowOptimizer optimizer {kinematics};
+
+    // Low line across the workspace, where the wrist comes close to a singularity with a constant q7
+    const Vector7d q_home = (Vector7d() << 0.0, -M_PI / 4, 0.0, -3 * M_PI / 4, 0.0, M_PI / 2, M_PI / 4).finished();
+    Affine start = kinematics.forward(q_home), end;
+    start.set_x(0.32);
+    start.set_y(0.2);
+    start.set_z(0.29);
+    end = start;
+    end.set_x(0.47);
+    end.set_y(-0.04);
+    end.set_z(0.26);
+
+    const auto q_start = kinematics.inverse(start, q_home(6), q_home);
+    REQUIRE( q_start );
+
+    const auto path = Path({start, end});
+    const auto profile = optimizer.optimize(path, Affine(), *q_start);
+    CHECK( profile.q7(0.0) == Approx((*q_start)(6)).margin(1e-12) );
+    CHECK( profile.s_step <= optimizer.s_step );
+
+    // The slope and curvature of the profile are bounded by the differences of its control points
+    const auto& c = profile.control_points;
+    bool is_within_limits {true};
+    for (size_t i = 1; i < c.size(); i += 1) {
+        is_within_limits &= std::abs(c[i] - c[i - 1]) <= optimizer.max_pdq7 * profile.s_step + 1e-9;
+        if (i + 1 < c.size()) {
+            is_within_limits &= std::abs(c[i + 1] - 2 * c[i] + c[i - 1]) <= optimizer.max_pddq7 * std::pow(profile.s_step, 2) + 1e-9;
+        }
+    }
+    CHECK( is_within_limits );
+
+    // Moving the elbow away from the singularity allows a faster trajectory than a constant q7
+    JointLimitCheck check {kinematics, max_joint_velocity, max_joint_acceleration, max_joint_jerk};
+    const auto constant_trajectory = check.parametrize(tp, path, Affine(), *q_start, max_velocity, max_acceleration, max_jerk);
+
+    check.redundancy = profile;
+    const auto trajectory = check.parametrize(tp, path, Affine(), *q_start, max_velocity, max_acceleration, max_jerk);
+    CHECK( check.check(trajectory, Affine(), *q_start).empty() );
+    CHECK( trajectory.states.back().t < constant_trajectory.states.back().t );
+
+    JointTrajectoryConversion conversion {kinematics, max_joint_velocity, max_joint_acceleration, max_joint_jerk};
+    conversion.redundancy = profile;
+    const auto q = conversion.convert(trajectory, Affine(), *q_start);
+    REQUIRE( q.size() == trajectory.states.size() );
+
+    bool follows_path {true};
+    for (size_t i = 0; i < q.size(); i += 1) {
+        const Affine pose = kinematics.forward(q[i]);
+        const Affine target = path.pose(trajectory.states[i].s);
+        follows_path &= (pose.translation() - target.translation()).norm() < 1e-6;
+        follows_path &= std::abs(q[i](6) - profile.q7(trajectory.states[i].s)) < 1e-6;
+    }
+    CHECK( follows_path );
+
+    // The collision check follows the same joint positions
+    CollisionCheck collision {kinematics};
+    collision.redundancy = profile;
+    CHECK_FALSE( collision.check(trajectory, Affine(), *q_start) );
+}
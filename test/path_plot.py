@@ -7,13 +7,8 @@ from _movex import Affine, Path
 
 
 def walk_through_path(path, s_diff=0.001):
-    s_list, q_list, pdq_list, pddq_list = [], [], [], []
-    for s in np.arange(0, p.length, s_diff):
-        s_list.append(s)
-        q_list.append(p.q(s))
-        pdq_list.append(p.pdq(s))
-        pddq_list.append(p.pddq(s))
-    return np.array(s_list), np.array(q_list), np.array(pdq_list), np.array(pddq_list)
+    s_list = np.arange(0, path.length, s_diff)
+    return s_list, path.q(s_list).T, path.pdq(s_list).T, path.pddq(s_list).T
 
 
 def plot_path(p: Path):
@@ -8,14 +8,9 @@ from _movex import Affine, Path, TimeParametrization
 
 def walk_through_path(traj):
     p = traj.path
-    t_list, s_list, q_list, dq_list, ddq_list = [], [], [], [], []
-    for state in traj.states:
-        t_list.append(state.t)
-        s_list.append(state.s)
-        q_list.append(p.q(state.s))
-        dq_list.append(p.dq(state.s, state.ds))
-        ddq_list.append(p.ddq(state.s, state.ds, state.dds))
-    return np.array(t_list), np.array(s_list), np.array(q_list), np.array(dq_list), np.array(ddq_list)
+    states = traj.states_array
+    t_list, s_list, ds_list, dds_list = states[:, 0], states[:, 1], states[:, 2], states[:, 3]
+    return t_list, s_list, p.q(s_list).T, p.dq(s_list, ds_list).T, p.ddq(s_list, ds_list, dds_list).T
 
 
 def plot_trajectory(traj):